@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "frame_buffer.h"
+#include "metrics.h"
+#include "numa_sampler.h"
+#include "process_table.h"
+#include "sampler_linux.h"
+#include "text_format.h"
+
+// ホットパスのマイクロベンチマーク集。外部依存を持たない自前ハーネスで
+// 各ケースを約0.5秒回し、ns/op とスループットを報告する。パーサ系は
+// bench/fixtures/ の大規模ホスト採取データを入力にするため、結果は
+// 実行ホストの /proc 構成に依存しない。
+
+namespace {
+// 最適化による計測対象の消去を防ぐ。Google Benchmark の DoNotOptimize 相当。
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// フィクスチャを丸ごと読み込む。見つからなければ空を返し呼び出し側で落とす。
+std::string load_fixture(const char *name) {
+    std::string path = BENCHMARK_FIXTURE_DIR "/";
+    path += name;
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return {};
+    }
+    std::string contents;
+    char buffer[64 * 1024];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        contents.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return contents;
+}
+
+// 1ケースを計測して報告する。所要が target_ns に達するまで倍々で反復数を
+// 増やすため、速いケースでも計測粒度に埋もれない。
+template <typename Fn>
+void run_case(const char *name, std::uint64_t bytes_per_op, Fn &&fn) {
+    using clock = std::chrono::steady_clock;
+    constexpr std::uint64_t target_ns = 500'000'000;
+
+    std::uint64_t iterations = 1;
+    std::uint64_t elapsed_ns = 0;
+    while (true) {
+        const auto start = clock::now();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        elapsed_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() -
+                                                                 start)
+                .count());
+        if (elapsed_ns >= target_ns || iterations >= (1ULL << 32)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    const double ns_per_op =
+        static_cast<double>(elapsed_ns) / static_cast<double>(iterations);
+    std::printf("%-28s %12llu iters %12.1f ns/op", name,
+                static_cast<unsigned long long>(iterations), ns_per_op);
+    if (bytes_per_op > 0) {
+        const double mib_per_sec =
+            static_cast<double>(bytes_per_op) * 1e9 / ns_per_op / (1024.0 * 1024.0);
+        std::printf(" %10.1f MiB/s", mib_per_sec);
+    }
+    std::printf("\n");
+}
+} // namespace
+
+int main() {
+    const std::string stat_fixture = load_fixture("proc_stat_128core.txt");
+    const std::string meminfo_fixture = load_fixture("proc_meminfo_large.txt");
+    const std::string pid_stat_fixture = load_fixture("proc_pid_stat.txt");
+    if (stat_fixture.empty() || meminfo_fixture.empty() ||
+        pid_stat_fixture.empty()) {
+        std::fprintf(stderr, "fixtures not found under %s\n",
+                     BENCHMARK_FIXTURE_DIR);
+        return 1;
+    }
+
+    CpuSnapshot snapshot;
+    run_case("parse_stat_128core", stat_fixture.size(), [&] {
+        LinuxSampler::parse_stat_buffer(stat_fixture.data(),
+                                        static_cast<ssize_t>(stat_fixture.size()),
+                                        snapshot);
+        do_not_optimize(snapshot.total_ticks);
+    });
+
+    run_case("parse_meminfo_large", meminfo_fixture.size(), [&] {
+        const MemoryStatus status = LinuxSampler::parse_meminfo_buffer(
+            meminfo_fixture.data(), static_cast<ssize_t>(meminfo_fixture.size()));
+        do_not_optimize(status.total_bytes);
+    });
+
+    const std::string node_fixture = load_fixture("proc_node_meminfo.txt");
+    if (!node_fixture.empty()) {
+        // 8ノードのスイープ相当コストを見るため1ノード分を計測する。
+        run_case("parse_node_meminfo", node_fixture.size(), [&] {
+            NumaNodeMemory node{};
+            NumaSampler::parse_node_meminfo(node_fixture.data(),
+                                            static_cast<ssize_t>(node_fixture.size()),
+                                            node);
+            do_not_optimize(node.free_bytes);
+        });
+    }
+
+    run_case("parse_process_stat", pid_stat_fixture.size(), [&] {
+        ProcessInfo info{};
+        ProcessScanner::parse_stat_text(pid_stat_fixture.data(),
+                                        static_cast<ssize_t>(pid_stat_fixture.size()),
+                                        1234567, 4096, info);
+        do_not_optimize(info.cpu_ticks);
+    });
+
+    // 実機 /proc のフルスキャン。環境依存だが、走査経路全体の回帰を
+    // 見るために残してある(プロセス数を併記する)。
+    {
+        ProcessScanner scanner;
+        if (scanner.valid()) {
+            std::vector<ProcessInfo> processes;
+            ProcessStateCounts counts{};
+            TickArena arena;
+            run_case("scan_tasks_live", 0, [&] {
+                scanner.scan(processes, counts, 100, 1, arena);
+                arena.reset();
+                do_not_optimize(counts.total);
+            });
+            std::printf("%-28s %12zu processes on this host\n", "  (scan_tasks_live)",
+                        counts.total);
+        }
+    }
+
+    CpuSnapshot prev = snapshot;
+    CpuSnapshot curr = snapshot;
+    curr.idle_ticks += 100;
+    curr.total_ticks += 1000;
+    run_case("compute_cpu_usage", 0, [&] {
+        const double usage = compute_cpu_usage(prev, curr);
+        do_not_optimize(usage);
+    });
+
+    FrameBuffer frame;
+    run_case("format_uptime", 0, [&] {
+        frame.clear();
+        append_uptime(frame, 1234567);
+        do_not_optimize(frame.size());
+    });
+
+    run_case("format_memory_mib", 0, [&] {
+        frame.clear();
+        append_memory_mib(frame, 123456789012ULL);
+        do_not_optimize(frame.size());
+    });
+
+    return 0;
+}
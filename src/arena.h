@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// 収集1周期ぶんの作業メモリをまとめて賄うバンプアロケータ。tick の
+// 末尾で reset() を呼ぶとカーソルを先頭へ戻すだけで全確保が無効になる
+// (O(1)、ブロックは解放せず使い回す)。常時起動のデプロイで一般ヒープの
+// 断片化が進まないよう、周期内の一時確保はここから取る。リング経由で
+// 描画側へ渡るデータは寿命が周期を跨ぐため対象にしない。
+class TickArena {
+public:
+    explicit TickArena(std::size_t block_size = 256 * 1024)
+        : block_size_(block_size) {}
+
+    ~TickArena() {
+        for (Block &block : blocks_) {
+            ::operator delete(block.base);
+        }
+    }
+
+    TickArena(const TickArena &) = delete;
+    TickArena &operator=(const TickArena &) = delete;
+
+    // alignment は2のべき乗前提。ブロックに収まらない大物は専用
+    // ブロックを切って返す(次の reset 以降も再利用される)。
+    void *allocate(std::size_t bytes, std::size_t alignment) {
+        while (block_index_ < blocks_.size()) {
+            Block &block = blocks_[block_index_];
+            const std::size_t aligned =
+                (block.offset + alignment - 1) & ~(alignment - 1);
+            if (aligned + bytes <= block.capacity) {
+                block.offset = aligned + bytes;
+                return block.base + aligned;
+            }
+            ++block_index_;
+        }
+        const std::size_t capacity = bytes > block_size_ ? bytes : block_size_;
+        Block block{};
+        block.base = static_cast<char *>(::operator new(capacity));
+        block.capacity = capacity;
+        block.offset = bytes;
+        blocks_.push_back(block);
+        block_index_ = blocks_.size() - 1;
+        return block.base;
+    }
+
+    // 全ブロックのカーソルを巻き戻す。メモリは保持したまま次周期へ回す。
+    void reset() {
+        for (Block &block : blocks_) {
+            block.offset = 0;
+        }
+        block_index_ = 0;
+    }
+
+private:
+    struct Block {
+        char *base{nullptr};
+        std::size_t capacity{0};
+        std::size_t offset{0};
+    };
+
+    std::size_t block_size_;
+    std::size_t block_index_{0};
+    std::vector<Block> blocks_;
+};
+
+// 標準コンテナを TickArena へ向けるアロケータアダプタ。解放は何も
+// しない(寿命は周期末尾の reset が握る)。
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(TickArena &arena) : arena_(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena()) {}
+
+    T *allocate(std::size_t count) {
+        return static_cast<T *>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, std::size_t) {}
+
+    TickArena *arena() const {
+        return arena_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena_ == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena_ != other.arena();
+    }
+
+private:
+    TickArena *arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// /proc 系テキストを1パスで走査するためのベクトル化パーサ部品。
+// 行の切り出しは SSE2 の16バイト比較(非対応環境は memchr)、数値変換は
+// 8桁ずつまとめて変換する SWAR で行い、meminfo 全体の解析を
+// マイクロ秒未満に収めることを狙う。
+
+// p から end の間で最初の改行位置を返す。見つからなければ end を返す。
+inline const char *find_line_end(const char *p, const char *end) {
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (p + 16 <= end) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+    while (p < end && *p != '\n') {
+        ++p;
+    }
+    return p;
+#else
+    const void *found = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return found != nullptr ? static_cast<const char *>(found) : end;
+#endif
+}
+
+// リトルエンディアン前提で ASCII 8桁を一括で整数へ畳み込む。
+// 乗算マスクの定番手順で、1桁ずつのループより大幅に速い。
+inline std::uint64_t parse_eight_digits(const char *p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, 8);
+    value = (value & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    value = (value & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (value & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+
+// 先頭の空白を読み飛ばした上で10進整数を読み取る。
+// 8桁以上連続する数字は SWAR でまとめて変換し、端数のみ1桁ずつ処理する。
+inline const char *parse_uint64_bulk(const char *p, const char *end,
+                                     std::uint64_t &out) {
+    while (p != end && *p == ' ') {
+        ++p;
+    }
+    // 数字の連続長を先に確定させ、8桁単位の変換を安全に行う。
+    const char *digits_end = p;
+    while (digits_end != end && *digits_end >= '0' && *digits_end <= '9') {
+        ++digits_end;
+    }
+    std::uint64_t value = 0;
+    while (digits_end - p >= 8) {
+        value = value * 100000000ULL + parse_eight_digits(p);
+        p += 8;
+    }
+    while (p != digits_end) {
+        value = value * 10 + static_cast<std::uint64_t>(*p - '0');
+        ++p;
+    }
+    out = value;
+    return digits_end;
+}
+
+// 行頭が key と一致するか調べ、一致したら直後の数値を kB→バイトへ変換して
+// 格納する。/proc/meminfo の「Key:  値 kB」形式専用のヘルパー。
+inline bool match_meminfo_line(const char *p, const char *line_end,
+                               const char *key, std::size_t key_length,
+                               std::uint64_t &out_bytes) {
+    if (static_cast<std::size_t>(line_end - p) <= key_length ||
+        std::memcmp(p, key, key_length) != 0) {
+        return false;
+    }
+    std::uint64_t kib = 0;
+    parse_uint64_bulk(p + key_length, line_end, kib);
+    out_bytes = kib * 1024;
+    return true;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+
+// cgroup v2 の CPU クォータ/メモリ上限に対する相対使用率コレクタ。
+// コンテナ内ではホスト全体の /proc/stat がミスリードになるため、
+// 自身(または --cgroup 指定)の cpu.stat / cpu.max / memory.current /
+// memory.max を保持fd+一括読みで毎周期読む。1Hz×数千Pod 運用を想定し、
+// 周期あたりのコストは4ファイルの pread と素朴な解析のみ。
+
+struct CgroupStatus {
+    // 前回周期からの usage_usec 差分を壁時計で割ったコア使用量。
+    double cores_used{};
+    // cpu.max のクォータ(コア数換算)。無制限("max")なら 0 のまま。
+    double quota_cores{};
+    std::uint64_t memory_current_bytes{};
+    // memory.max。無制限なら 0 のまま。
+    std::uint64_t memory_max_bytes{};
+    // cores_used が差分から計算できた周期のみ true(初回は false)。
+    bool cpu_valid{false};
+    bool memory_valid{false};
+    bool valid{false};
+};
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "bulk_parser.h"
+#include "proc_file.h"
+
+class CgroupSampler {
+public:
+    CgroupSampler() = default;
+
+    CgroupSampler(const CgroupSampler &) = delete;
+    CgroupSampler &operator=(const CgroupSampler &) = delete;
+
+    // path_override が null なら /proc/self/cgroup の "0::<path>" 行から
+    // 自身の cgroup を解決する。指定時はまずそのままのディレクトリとして
+    // 試し、駄目なら /sys/fs/cgroup 相対として扱う。v1 ホストや階層が
+    // 読めない場合は false。
+    bool init(const char *path_override) {
+        char directory[512];
+        if (path_override != nullptr) {
+            if (path_override[0] == '/') {
+                std::snprintf(directory, sizeof(directory), "%s", path_override);
+                if (open_files(directory)) {
+                    return true;
+                }
+            }
+            std::snprintf(directory, sizeof(directory), "/sys/fs/cgroup%s%s",
+                          path_override[0] == '/' ? "" : "/", path_override);
+        } else if (!resolve_own_cgroup(directory, sizeof(directory))) {
+            return false;
+        }
+        return open_files(directory);
+    }
+
+    CgroupStatus sample() {
+        CgroupStatus status{};
+        sample_cpu(status);
+        sample_memory(status);
+        status.valid = status.cpu_valid || status.memory_valid;
+        return status;
+    }
+
+private:
+    // ディレクトリ配下の4ファイルを開き直す。CPU かメモリの少なくとも
+    // 一方が読めれば有効とする(コントローラ未委譲の階層があるため)。
+    bool open_files(const char *directory) {
+        char path[600];
+        std::snprintf(path, sizeof(path), "%s/cpu.stat", directory);
+        const bool have_cpu_stat = cpu_stat_.open(path, 1024);
+        std::snprintf(path, sizeof(path), "%s/cpu.max", directory);
+        cpu_max_.open(path, 128);
+        std::snprintf(path, sizeof(path), "%s/memory.current", directory);
+        const bool have_memory = memory_current_.open(path, 128);
+        std::snprintf(path, sizeof(path), "%s/memory.max", directory);
+        memory_max_.open(path, 128);
+        return have_cpu_stat || have_memory;
+    }
+
+    // /proc/self/cgroup の v2 統一階層行からディレクトリを組み立てる。
+    static bool resolve_own_cgroup(char *directory, std::size_t capacity) {
+        ProcFile self("/proc/self/cgroup", 1024);
+        const ssize_t length = self.read_all();
+        if (length <= 0) {
+            return false;
+        }
+        const char *p = self.data();
+        const char *end = p + length;
+        while (p < end) {
+            const char *line_end = find_line_end(p, end);
+            if (line_end - p > 3 && p[0] == '0' && p[1] == ':' && p[2] == ':') {
+                const std::size_t path_length =
+                    static_cast<std::size_t>(line_end - (p + 3));
+                if (path_length + 16 >= capacity) {
+                    return false;
+                }
+                std::memcpy(directory, "/sys/fs/cgroup", 14);
+                std::memcpy(directory + 14, p + 3, path_length);
+                directory[14 + path_length] = '\0';
+                return true;
+            }
+            p = line_end + 1;
+        }
+        return false;
+    }
+
+    void sample_cpu(CgroupStatus &status) {
+        const ssize_t length = cpu_stat_.read_all();
+        if (length <= 0) {
+            return;
+        }
+        // cpu.stat は "usage_usec N" が先頭行に来る。行頭一致だけ確認する。
+        std::uint64_t usage_usec = 0;
+        const char *p = cpu_stat_.data();
+        const char *end = p + length;
+        while (p < end) {
+            const char *line_end = find_line_end(p, end);
+            if (line_end - p > 11 && std::memcmp(p, "usage_usec ", 11) == 0) {
+                parse_uint64_bulk(p + 11, line_end, usage_usec);
+                break;
+            }
+            p = line_end + 1;
+        }
+
+        const std::uint64_t now_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+        if (last_sample_ns_ != 0 && now_ns > last_sample_ns_ &&
+            usage_usec >= last_usage_usec_) {
+            const std::uint64_t usage_delta_ns =
+                (usage_usec - last_usage_usec_) * 1000ULL;
+            status.cores_used = static_cast<double>(usage_delta_ns) /
+                                static_cast<double>(now_ns - last_sample_ns_);
+            status.cpu_valid = true;
+        }
+        last_usage_usec_ = usage_usec;
+        last_sample_ns_ = now_ns;
+
+        // cpu.max は "<quota> <period>" または "max <period>"。
+        const ssize_t max_length = cpu_max_.read_all();
+        if (max_length > 3 && std::memcmp(cpu_max_.data(), "max", 3) != 0) {
+            std::uint64_t quota = 0;
+            std::uint64_t period = 0;
+            const char *cursor = parse_uint64_bulk(
+                cpu_max_.data(), cpu_max_.data() + max_length, quota);
+            parse_uint64_bulk(cursor, cpu_max_.data() + max_length, period);
+            if (period > 0) {
+                status.quota_cores =
+                    static_cast<double>(quota) / static_cast<double>(period);
+            }
+        }
+    }
+
+    void sample_memory(CgroupStatus &status) {
+        const ssize_t current_length = memory_current_.read_all();
+        if (current_length <= 0) {
+            return;
+        }
+        parse_uint64_bulk(memory_current_.data(),
+                          memory_current_.data() + current_length,
+                          status.memory_current_bytes);
+        status.memory_valid = true;
+
+        const ssize_t max_length = memory_max_.read_all();
+        if (max_length > 3 && std::memcmp(memory_max_.data(), "max", 3) != 0) {
+            parse_uint64_bulk(memory_max_.data(), memory_max_.data() + max_length,
+                              status.memory_max_bytes);
+        }
+    }
+
+    ProcFile cpu_stat_;
+    ProcFile cpu_max_;
+    ProcFile memory_current_;
+    ProcFile memory_max_;
+    std::uint64_t last_usage_usec_{0};
+    std::uint64_t last_sample_ns_{0};
+};
+
+#endif // !_WIN32
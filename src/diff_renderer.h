@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "frame_buffer.h"
+#include "terminal_output.h"
+
+// 前回表示したフレームを保持し、変化した行だけをカーソル移動付きで
+// 送出する差分レンダラ。毎回の全画面クリア+全行再送を避けることで、
+// ちらつきと SSH 越しの転送量(定常時は数十バイト程度)を抑える。
+class DiffRenderer {
+public:
+    DiffRenderer() {
+        previous_.reserve(64 * 1024);
+    }
+
+    // 組み立て済みフレームを端末へ反映する。初回のみ全画面を送り、
+    // 以降は行単位の比較で変化した行だけを書き換える。
+    void present(const FrameBuffer &frame) {
+        output_.clear();
+        if (first_) {
+            output_.append("\x1b[2J\x1b[H");
+            output_.append(std::string_view(frame.data(), frame.size()));
+            first_ = false;
+        } else {
+            emit_changed_lines(frame);
+        }
+        output_.flush_to_stdout();
+
+        previous_.assign(frame.data(), frame.data() + frame.size());
+    }
+
+    // 非ブロッキング出力経由で反映する版。差分の組み立てと状態更新は
+    // 同じで、送出だけをキュー任せにする。呼び出し側は out.drain() が
+    // true のときだけ呼ぶこと(途中で切れた差分列は端末状態を壊すため)。
+    void present(const FrameBuffer &frame, NonblockingStdout &out) {
+        output_.clear();
+        if (first_) {
+            output_.append("\x1b[2J\x1b[H");
+            output_.append(std::string_view(frame.data(), frame.size()));
+            first_ = false;
+        } else {
+            emit_changed_lines(frame);
+        }
+        out.submit(output_.data(), output_.size());
+
+        previous_.assign(frame.data(), frame.data() + frame.size());
+    }
+
+    // 次回の present で全画面を再送させる。端末サイズ変更などの
+    // 画面が信用できなくなった場面で呼ぶ。
+    void invalidate() {
+        first_ = true;
+    }
+
+private:
+    // 新旧フレームを行単位で突き合わせ、差分行のみを
+    // 「カーソル移動+行クリア+新行」の並びで output_ へ積む。
+    void emit_changed_lines(const FrameBuffer &frame) {
+        const char *new_cursor = frame.data();
+        const char *new_end = frame.data() + frame.size();
+        const char *old_cursor = previous_.data();
+        const char *old_end = previous_.data() + previous_.size();
+
+        std::size_t row = 1;
+        std::size_t old_rows = 0;
+        while (new_cursor < new_end) {
+            const std::string_view new_line = next_line(new_cursor, new_end);
+            if (old_cursor < old_end) {
+                const std::string_view old_line = next_line(old_cursor, old_end);
+                ++old_rows;
+                if (new_line == old_line) {
+                    ++row;
+                    continue;
+                }
+            }
+            move_to_row(row);
+            output_.append("\x1b[2K");
+            output_.append(new_line);
+            ++row;
+        }
+        // 前回の方が行数が多い場合は残りを消す。
+        while (old_cursor < old_end) {
+            next_line(old_cursor, old_end);
+            ++old_rows;
+        }
+        if (old_rows >= row) {
+            move_to_row(row);
+            output_.append("\x1b[0J");
+        }
+    }
+
+    // cursor から次の改行までを切り出し、cursor を行末の先へ進める。
+    static std::string_view next_line(const char *&cursor, const char *end) {
+        const char *line_end = static_cast<const char *>(
+            std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        const std::string_view line(cursor, static_cast<std::size_t>(line_end - cursor));
+        cursor = line_end < end ? line_end + 1 : end;
+        return line;
+    }
+
+    void move_to_row(std::size_t row) {
+        output_.append("\x1b[");
+        output_.append_uint(row);
+        output_.append(";1H");
+    }
+
+    std::vector<char> previous_;
+    FrameBuffer output_;
+    bool first_{true};
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "recorder.h"
+
+// フリート集約で1ホスト1サンプルを運ぶデータグラム。レコード部は
+// リングファイルと同じ HistoryRecord レイアウトを再利用する。
+struct FleetDatagram {
+    char magic[4];
+    std::uint32_t version;
+    char hostname[32];
+    HistoryRecord record;
+};
+
+inline constexpr char fleet_magic[4] = {'B', 'T', 'F', '0'};
+
+// 毎サンプルを1データグラムで集約ホストへ送る発行側。
+// 送信は sendto 1回だけで、失敗してもサンプリングは継続する。
+class FleetPublisher {
+public:
+    ~FleetPublisher() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    // "アドレス:ポート" 形式の宛先を解決してソケットを用意する。
+    bool open(const char *destination) {
+        const char *colon = std::strrchr(destination, ':');
+        if (colon == nullptr) {
+            return false;
+        }
+        char address[64];
+        const std::size_t address_length =
+            std::min(static_cast<std::size_t>(colon - destination), sizeof(address) - 1);
+        std::memcpy(address, destination, address_length);
+        address[address_length] = '\0';
+
+        destination_.sin_family = AF_INET;
+        destination_.sin_port = htons(static_cast<std::uint16_t>(
+            std::strtol(colon + 1, nullptr, 10)));
+        if (::inet_pton(AF_INET, address, &destination_.sin_addr) != 1) {
+            return false;
+        }
+        fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        ::gethostname(hostname_, sizeof(hostname_) - 1);
+        return true;
+    }
+
+    bool valid() const {
+        return fd_ >= 0;
+    }
+
+    void publish(const HistoryRecord &record) {
+        FleetDatagram datagram{};
+        std::memcpy(datagram.magic, fleet_magic, sizeof(fleet_magic));
+        datagram.version = RING_FILE_VERSION;
+        std::memcpy(datagram.hostname, hostname_, sizeof(datagram.hostname));
+        datagram.record = record;
+        ::sendto(fd_, &datagram, sizeof(datagram), 0,
+                 reinterpret_cast<const sockaddr *>(&destination_),
+                 sizeof(destination_));
+    }
+
+private:
+    int fd_{-1};
+    sockaddr_in destination_{};
+    char hostname_[32]{};
+};
+
+// 集約側が保持するホスト1台分の最新状態。
+struct FleetHost {
+    char hostname[32]{};
+    HistoryRecord last{};
+    std::uint64_t last_seen_ms{};
+    bool used{false};
+};
+
+// 数百ホストからのデータグラムを recvmmsg でまとめて取り込み、
+// 事前確保したフラットなホスト表(開番地法)を更新する集約器。
+class FleetAggregator {
+public:
+    static constexpr std::size_t host_capacity = 1024;
+    static constexpr std::size_t batch_size = 64;
+
+    FleetAggregator() : hosts_(host_capacity) {}
+
+    ~FleetAggregator() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool open(std::uint16_t port) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (::bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    bool valid() const {
+        return fd_ >= 0;
+    }
+
+    // 溜まっているデータグラムを1システムコールあたり最大 batch_size 件
+    // まとめて取り込み、ホスト表を更新する。取り込んだ件数を返す。
+    std::size_t drain(std::uint64_t now_ms) {
+        std::size_t received_total = 0;
+        FleetDatagram datagrams[batch_size];
+        mmsghdr headers[batch_size];
+        iovec iovecs[batch_size];
+        while (true) {
+            for (std::size_t i = 0; i < batch_size; ++i) {
+                iovecs[i].iov_base = &datagrams[i];
+                iovecs[i].iov_len = sizeof(FleetDatagram);
+                std::memset(&headers[i].msg_hdr, 0, sizeof(msghdr));
+                headers[i].msg_hdr.msg_iov = &iovecs[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int received =
+                ::recvmmsg(fd_, headers, batch_size, 0, nullptr);
+            if (received <= 0) {
+                return received_total;
+            }
+            for (int i = 0; i < received; ++i) {
+                if (headers[i].msg_len != sizeof(FleetDatagram)) {
+                    continue;
+                }
+                ingest(datagrams[i], now_ms);
+            }
+            received_total += static_cast<std::size_t>(received);
+            if (static_cast<std::size_t>(received) < batch_size) {
+                return received_total;
+            }
+        }
+    }
+
+    const std::vector<FleetHost> &hosts() const {
+        return hosts_;
+    }
+
+private:
+    static std::size_t hash_hostname(const char *hostname) {
+        // FNV-1a。ホスト名は短いのでこれで十分散る。
+        std::size_t hash = 1469598103934665603ULL;
+        for (const char *p = hostname; *p != '\0'; ++p) {
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    void ingest(const FleetDatagram &datagram, std::uint64_t now_ms) {
+        if (std::memcmp(datagram.magic, fleet_magic, sizeof(fleet_magic)) != 0 ||
+            datagram.version != RING_FILE_VERSION) {
+            return;
+        }
+        std::size_t index = hash_hostname(datagram.hostname) & (host_capacity - 1);
+        for (std::size_t probes = 0; probes < host_capacity; ++probes) {
+            FleetHost &host = hosts_[index];
+            if (!host.used) {
+                std::memcpy(host.hostname, datagram.hostname, sizeof(host.hostname));
+                host.used = true;
+            }
+            if (std::strncmp(host.hostname, datagram.hostname,
+                             sizeof(host.hostname)) == 0) {
+                host.last = datagram.record;
+                host.last_seen_ms = now_ms;
+                return;
+            }
+            index = (index + 1) & (host_capacity - 1);
+        }
+        // 表が満杯の場合は新規ホストを黙って落とす(容量は1024ホスト)。
+    }
+
+    int fd_{-1};
+    std::vector<FleetHost> hosts_;
+};
+
+#endif // !_WIN32
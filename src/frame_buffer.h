@@ -0,0 +1,121 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// 1フレーム分の画面文字列を事前確保済みバッファへ組み立てるレンダラ基盤。
+// ostringstream と異なり定常状態ではヒープ確保を行わず、
+// 完成したフレームを1回の write(2) で端末へ送出する。
+class FrameBuffer {
+public:
+    explicit FrameBuffer(std::size_t capacity = 64 * 1024) {
+        buffer_.reserve(capacity);
+    }
+
+    // フレームの組み立てを最初からやり直す。確保済み容量は保持する。
+    void clear() {
+        buffer_.clear();
+    }
+
+    void append(std::string_view text) {
+        buffer_.insert(buffer_.end(), text.begin(), text.end());
+    }
+
+    void append(char c) {
+        buffer_.push_back(c);
+    }
+
+    // 符号なし整数を to_chars で10進文字列化して追記する。
+    void append_uint(std::uint64_t value) {
+        char scratch[20];
+        const auto result = std::to_chars(scratch, scratch + sizeof(scratch), value);
+        append(std::string_view(scratch, result.ptr - scratch));
+    }
+
+    // 固定小数表記で double を追記する。表示用途なので精度は桁数指定のみ。
+    void append_fixed(double value, int precision) {
+        char scratch[32];
+        const auto result = std::to_chars(scratch, scratch + sizeof(scratch), value,
+                                          std::chars_format::fixed, precision);
+        append(std::string_view(scratch, result.ptr - scratch));
+    }
+
+    // 右詰め幅指定つきの固定小数表記。%Cpu の列揃えに使う。
+    void append_fixed_padded(double value, int precision, int width) {
+        char scratch[32];
+        const auto result = std::to_chars(scratch, scratch + sizeof(scratch), value,
+                                          std::chars_format::fixed, precision);
+        const int length = static_cast<int>(result.ptr - scratch);
+        for (int i = length; i < width; ++i) {
+            append(' ');
+        }
+        append(std::string_view(scratch, length));
+    }
+
+    // 右詰め幅指定つきの符号なし整数表記。PID などの列揃えに使う。
+    void append_uint_padded(std::uint64_t value, int width) {
+        char scratch[20];
+        const auto result = std::to_chars(scratch, scratch + sizeof(scratch), value);
+        const int length = static_cast<int>(result.ptr - scratch);
+        for (int i = length; i < width; ++i) {
+            append(' ');
+        }
+        append(std::string_view(scratch, length));
+    }
+
+    // 左詰め幅指定つきの符号なし整数表記。コア番号の列揃えに使う。
+    void append_uint_padded_left(std::uint64_t value, int width) {
+        char scratch[20];
+        const auto result = std::to_chars(scratch, scratch + sizeof(scratch), value);
+        const int length = static_cast<int>(result.ptr - scratch);
+        append(std::string_view(scratch, length));
+        for (int i = length; i < width; ++i) {
+            append(' ');
+        }
+    }
+
+    // 2桁ゼロ詰めの整数表記。稼働時間の 時:分 表示に使う。
+    void append_uint_2digit(std::uint64_t value) {
+        append(static_cast<char>('0' + (value / 10) % 10));
+        append(static_cast<char>('0' + value % 10));
+    }
+
+    const char *data() const {
+        return buffer_.data();
+    }
+
+    std::size_t size() const {
+        return buffer_.size();
+    }
+
+    // 完成したフレームを1回のシステムコールで標準出力へ書き出す。
+    // Windows では write(2) が使えないため fwrite+fflush で代替する。
+    void flush_to_stdout() const {
+#ifdef _WIN32
+        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+        std::fflush(stdout);
+#else
+        std::size_t written = 0;
+        while (written < buffer_.size()) {
+            const ssize_t n = ::write(STDOUT_FILENO, buffer_.data() + written,
+                                      buffer_.size() - written);
+            if (n <= 0) {
+                return;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+#endif
+    }
+
+private:
+    std::vector<char> buffer_;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <dlfcn.h>
+#endif
+
+// NVML を実行時に dlopen で解決する GPU コレクタ。SDK 無しでビルドでき、
+// ドライバの無いホストでは start が false を返して無効のままとなる。
+// NVML 呼び出しは数十msブロックし得るため専用スレッドで回し、結果は
+// シーケンスロック越しに公開する。収集・描画側の読み取りは待ちを含まない。
+// スナップショット構造体はガード外に置き、非対応環境でも Sample が
+// 空の GPU 欄を持てるようにする。
+
+// GPU 1枚分の表示用情報。NVML の戻り値をそのまま写す。
+struct GpuInfo {
+    unsigned utilization_percent{};
+    std::uint64_t memory_used_bytes{};
+    std::uint64_t memory_total_bytes{};
+    unsigned power_milliwatts{};
+};
+
+// 全 GPU 分のスナップショット。固定長にしてシーケンスロックの
+// コピーが memcpy 相当で済むようにする。
+struct GpuSnapshot {
+    static constexpr std::uint32_t max_gpus = 16;
+    std::uint32_t count{};
+    GpuInfo gpus[max_gpus];
+    bool valid{false};
+};
+
+#ifndef _WIN32
+
+class GpuSampler {
+public:
+    GpuSampler() = default;
+
+    ~GpuSampler() {
+        if (poller_.joinable()) {
+            stop_.store(true, std::memory_order_release);
+            poller_.join();
+        }
+        if (shutdown_ != nullptr) {
+            shutdown_();
+        }
+        if (library_ != nullptr) {
+            dlclose(library_);
+        }
+    }
+
+    GpuSampler(const GpuSampler &) = delete;
+    GpuSampler &operator=(const GpuSampler &) = delete;
+
+    // NVML を解決・初期化してポーリングスレッドを起動する。ライブラリや
+    // デバイスが無いホストでは false を返し、以後 read は valid=false を返す。
+    bool start(std::chrono::milliseconds interval) {
+        library_ = dlopen("libnvidia-ml.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (library_ == nullptr) {
+            return false;
+        }
+        init_ = reinterpret_cast<InitFn>(dlsym(library_, "nvmlInit_v2"));
+        shutdown_ = reinterpret_cast<ShutdownFn>(dlsym(library_, "nvmlShutdown"));
+        device_count_ =
+            reinterpret_cast<DeviceCountFn>(dlsym(library_, "nvmlDeviceGetCount_v2"));
+        device_handle_ = reinterpret_cast<DeviceHandleFn>(
+            dlsym(library_, "nvmlDeviceGetHandleByIndex_v2"));
+        utilization_ = reinterpret_cast<UtilizationFn>(
+            dlsym(library_, "nvmlDeviceGetUtilizationRates"));
+        memory_info_ =
+            reinterpret_cast<MemoryInfoFn>(dlsym(library_, "nvmlDeviceGetMemoryInfo"));
+        power_usage_ =
+            reinterpret_cast<PowerUsageFn>(dlsym(library_, "nvmlDeviceGetPowerUsage"));
+        if (init_ == nullptr || shutdown_ == nullptr || device_count_ == nullptr ||
+            device_handle_ == nullptr || utilization_ == nullptr ||
+            memory_info_ == nullptr || power_usage_ == nullptr) {
+            shutdown_ = nullptr;
+            return false;
+        }
+        if (init_() != 0) {
+            shutdown_ = nullptr;
+            return false;
+        }
+        unsigned count = 0;
+        if (device_count_(&count) != 0 || count == 0) {
+            return false;
+        }
+        device_total_ = count < GpuSnapshot::max_gpus ? count : GpuSnapshot::max_gpus;
+        poller_ = std::thread(&GpuSampler::poll_loop, this, interval);
+        return true;
+    }
+
+    // 最新スナップショットを取り出す。書き込み中(奇数シーケンス)に
+    // 当たった場合のみ読み直す。ポーラ停止中は valid=false のまま返る。
+    void read(GpuSnapshot &out) const {
+        while (true) {
+            const std::uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1U) {
+                continue;
+            }
+            out = snapshot_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+    }
+
+private:
+    // NVML の戻り値型のうち必要な部分だけを手元で定義する。
+    // ABI は安定しており、SDK ヘッダへの依存を持たないための措置。
+    struct NvmlUtilization {
+        unsigned gpu;
+        unsigned memory;
+    };
+    struct NvmlMemory {
+        unsigned long long total;
+        unsigned long long free;
+        unsigned long long used;
+    };
+
+    using InitFn = int (*)();
+    using ShutdownFn = int (*)();
+    using DeviceCountFn = int (*)(unsigned *);
+    using DeviceHandleFn = int (*)(unsigned, void **);
+    using UtilizationFn = int (*)(void *, NvmlUtilization *);
+    using MemoryInfoFn = int (*)(void *, NvmlMemory *);
+    using PowerUsageFn = int (*)(void *, unsigned *);
+
+    void poll_loop(std::chrono::milliseconds interval) {
+        auto next_tick = std::chrono::steady_clock::now();
+        while (!stop_.load(std::memory_order_acquire)) {
+            GpuSnapshot fresh{};
+            for (unsigned i = 0; i < device_total_; ++i) {
+                void *device = nullptr;
+                if (device_handle_(i, &device) != 0) {
+                    continue;
+                }
+                GpuInfo &info = fresh.gpus[fresh.count];
+                NvmlUtilization utilization{};
+                if (utilization_(device, &utilization) == 0) {
+                    info.utilization_percent = utilization.gpu;
+                }
+                NvmlMemory memory{};
+                if (memory_info_(device, &memory) == 0) {
+                    info.memory_used_bytes = memory.used;
+                    info.memory_total_bytes = memory.total;
+                }
+                power_usage_(device, &info.power_milliwatts);
+                ++fresh.count;
+            }
+            fresh.valid = fresh.count > 0;
+            publish(fresh);
+
+            next_tick += interval;
+            std::this_thread::sleep_until(next_tick);
+        }
+    }
+
+    // シーケンスを奇数に進めてから本体を書き、偶数へ戻して公開する。
+    // 書き手はこのスレッドのみなので fetch_add は不要。
+    void publish(const GpuSnapshot &fresh) {
+        const std::uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        snapshot_ = fresh;
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    void *library_{nullptr};
+    InitFn init_{nullptr};
+    ShutdownFn shutdown_{nullptr};
+    DeviceCountFn device_count_{nullptr};
+    DeviceHandleFn device_handle_{nullptr};
+    UtilizationFn utilization_{nullptr};
+    MemoryInfoFn memory_info_{nullptr};
+    PowerUsageFn power_usage_{nullptr};
+    unsigned device_total_{0};
+
+    GpuSnapshot snapshot_{};
+    std::atomic<std::uint32_t> sequence_{0};
+    std::atomic<bool> stop_{false};
+    std::thread poller_;
+};
+
+#endif // !_WIN32
@@ -0,0 +1,412 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "recorder.h"
+
+// リングファイルの第二階層となる長期履歴アーカイブ。レコードを
+// ブロック単位で差分+varint 符号化し、タイムスタンプは差分の差分
+// (定周期なら毎レコードほぼ0)で潰す。total_ticks 系の単調メトリクス
+// も差分が小さいため、1Hz で1週間分が数MBに収まる。ブロックごとの
+// 時刻範囲を索引として末尾に持ち、再生側は全体を復号せず二分探索で
+// 目的の時間帯へ跳べる。
+
+inline constexpr char archive_magic[8] = {'B', 'T', 'A', 'R', 'C', 'H', '0', '\0'};
+inline constexpr std::uint32_t ARCHIVE_FILE_VERSION = 1;
+// 1ブロックあたりのレコード数。1Hz なら約8.5分で、索引1エントリ
+// 32バイトに対して十分に粗い。
+inline constexpr std::uint32_t archive_block_records = 512;
+
+// ファイル先頭の固定ヘッダ。ブロック列はこの直後から始まる。
+struct ArchiveFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+// ブロック索引の1エントリ。offset はファイル先頭からのブロック位置。
+struct ArchiveBlockIndex {
+    std::uint64_t first_timestamp_ms;
+    std::uint64_t last_timestamp_ms;
+    std::uint64_t offset;
+    std::uint32_t bytes;
+    std::uint32_t records;
+};
+
+// ファイル末尾の固定フッタ。索引位置だけを指す。
+struct ArchiveFileFooter {
+    std::uint64_t index_offset;
+    std::uint64_t block_count;
+    char magic[8];
+};
+
+// 符号付き差分を下位ビットへ折り返す zigzag 符号。
+inline std::uint64_t zigzag_encode(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzag_decode(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^
+           -static_cast<std::int64_t>(value & 1);
+}
+
+// LEB128 可変長整数。小さな差分は1バイトで収まる。
+inline void append_varint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+inline const std::uint8_t *read_varint(const std::uint8_t *p,
+                                       const std::uint8_t *end,
+                                       std::uint64_t &value) {
+    value = 0;
+    int shift = 0;
+    while (p < end) {
+        const std::uint8_t byte = *p++;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return p;
+        }
+        shift += 7;
+    }
+    return nullptr;
+}
+
+// レコード間差分の符号化状態。ブロック先頭でリセットされるため、
+// ブロックは互いに独立して復号できる。
+struct ArchiveDeltaState {
+    std::uint64_t timestamp_ms{0};
+    std::int64_t timestamp_delta{0};
+    std::uint64_t uptime{0};
+    std::int64_t cpu_centi{0};
+    std::int64_t mem_total{0};
+    std::int64_t mem_available{0};
+    std::int64_t tasks[5]{};
+    std::int64_t loads[3]{};
+    std::uint64_t flags{0};
+};
+
+// 1レコードを直前レコードとの差分で block へ追記する。%CPU とロードは
+// 0.01 単位へ量子化する(表示桁と同じで、履歴用途では十分)。
+inline void archive_encode_record(const HistoryRecord &record,
+                                  ArchiveDeltaState &state, bool first,
+                                  std::vector<std::uint8_t> &block) {
+    if (first) {
+        append_varint(block, record.timestamp_ms);
+        state.timestamp_delta = 0;
+    } else {
+        const std::int64_t delta = static_cast<std::int64_t>(record.timestamp_ms) -
+                                   static_cast<std::int64_t>(state.timestamp_ms);
+        append_varint(block, zigzag_encode(delta - state.timestamp_delta));
+        state.timestamp_delta = delta;
+    }
+    state.timestamp_ms = record.timestamp_ms;
+
+    const auto encode_delta = [&block](std::int64_t &previous, std::int64_t value) {
+        append_varint(block, zigzag_encode(value - previous));
+        previous = value;
+    };
+
+    append_varint(block,
+                  zigzag_encode(static_cast<std::int64_t>(record.uptime_seconds) -
+                                static_cast<std::int64_t>(state.uptime)));
+    state.uptime = record.uptime_seconds;
+
+    encode_delta(state.cpu_centi,
+                 static_cast<std::int64_t>(record.cpu_usage * 100.0 + 0.5));
+    encode_delta(state.mem_total, static_cast<std::int64_t>(record.mem_total_bytes));
+    encode_delta(state.mem_available,
+                 static_cast<std::int64_t>(record.mem_available_bytes));
+    encode_delta(state.tasks[0], record.tasks_total);
+    encode_delta(state.tasks[1], record.tasks_running);
+    encode_delta(state.tasks[2], record.tasks_sleeping);
+    encode_delta(state.tasks[3], record.tasks_stopped);
+    encode_delta(state.tasks[4], record.tasks_zombie);
+    encode_delta(state.loads[0],
+                 static_cast<std::int64_t>(record.load_one * 100.0f + 0.5f));
+    encode_delta(state.loads[1],
+                 static_cast<std::int64_t>(record.load_five * 100.0f + 0.5f));
+    encode_delta(state.loads[2],
+                 static_cast<std::int64_t>(record.load_fifteen * 100.0f + 0.5f));
+    append_varint(block, zigzag_encode(static_cast<std::int64_t>(record.flags) -
+                                       static_cast<std::int64_t>(state.flags)));
+    state.flags = record.flags;
+}
+
+inline const std::uint8_t *archive_decode_record(const std::uint8_t *p,
+                                                 const std::uint8_t *end,
+                                                 ArchiveDeltaState &state,
+                                                 bool first,
+                                                 HistoryRecord &record) {
+    std::uint64_t raw = 0;
+    if ((p = read_varint(p, end, raw)) == nullptr) {
+        return nullptr;
+    }
+    if (first) {
+        state.timestamp_ms = raw;
+        state.timestamp_delta = 0;
+    } else {
+        state.timestamp_delta += zigzag_decode(raw);
+        state.timestamp_ms =
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(state.timestamp_ms) +
+                                       state.timestamp_delta);
+    }
+    record.timestamp_ms = state.timestamp_ms;
+
+    const auto decode_delta = [&](std::int64_t &previous) -> bool {
+        std::uint64_t encoded = 0;
+        if ((p = read_varint(p, end, encoded)) == nullptr) {
+            return false;
+        }
+        previous += zigzag_decode(encoded);
+        return true;
+    };
+
+    std::int64_t uptime = static_cast<std::int64_t>(state.uptime);
+    if (!decode_delta(uptime)) {
+        return nullptr;
+    }
+    state.uptime = static_cast<std::uint64_t>(uptime);
+    record.uptime_seconds = state.uptime;
+
+    if (!decode_delta(state.cpu_centi) || !decode_delta(state.mem_total) ||
+        !decode_delta(state.mem_available) || !decode_delta(state.tasks[0]) ||
+        !decode_delta(state.tasks[1]) || !decode_delta(state.tasks[2]) ||
+        !decode_delta(state.tasks[3]) || !decode_delta(state.tasks[4]) ||
+        !decode_delta(state.loads[0]) || !decode_delta(state.loads[1]) ||
+        !decode_delta(state.loads[2])) {
+        return nullptr;
+    }
+    std::int64_t flags = static_cast<std::int64_t>(state.flags);
+    if (!decode_delta(flags)) {
+        return nullptr;
+    }
+    state.flags = static_cast<std::uint64_t>(flags);
+
+    record.cpu_usage = static_cast<double>(state.cpu_centi) / 100.0;
+    record.mem_total_bytes = static_cast<std::uint64_t>(state.mem_total);
+    record.mem_available_bytes = static_cast<std::uint64_t>(state.mem_available);
+    record.tasks_total = static_cast<std::uint32_t>(state.tasks[0]);
+    record.tasks_running = static_cast<std::uint32_t>(state.tasks[1]);
+    record.tasks_sleeping = static_cast<std::uint32_t>(state.tasks[2]);
+    record.tasks_stopped = static_cast<std::uint32_t>(state.tasks[3]);
+    record.tasks_zombie = static_cast<std::uint32_t>(state.tasks[4]);
+    record.load_one = static_cast<float>(state.loads[0]) / 100.0f;
+    record.load_five = static_cast<float>(state.loads[1]) / 100.0f;
+    record.load_fifteen = static_cast<float>(state.loads[2]) / 100.0f;
+    record.flags = static_cast<std::uint32_t>(state.flags);
+    return p;
+}
+
+// アーカイブの書き手。append でブロックを育て、満杯ごとに書き出して
+// 索引エントリを積む。finish で残りと索引・フッタを確定する。
+class ArchiveWriter {
+public:
+    ArchiveWriter() = default;
+
+    ~ArchiveWriter() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    ArchiveWriter(const ArchiveWriter &) = delete;
+    ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+
+    bool open(const char *path) {
+        fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        ArchiveFileHeader header{};
+        std::memcpy(header.magic, archive_magic, 8);
+        header.version = ARCHIVE_FILE_VERSION;
+        if (::write(fd_, &header, sizeof(header)) != sizeof(header)) {
+            return false;
+        }
+        offset_ = sizeof(header);
+        return true;
+    }
+
+    void append(const HistoryRecord &record) {
+        if (block_records_ == 0) {
+            state_ = ArchiveDeltaState{};
+            block_first_ts_ = record.timestamp_ms;
+        }
+        archive_encode_record(record, state_, block_records_ == 0, block_);
+        block_last_ts_ = record.timestamp_ms;
+        if (++block_records_ >= archive_block_records) {
+            flush_block();
+        }
+    }
+
+    // 残ブロック・索引・フッタを書き切る。成功時のみ true。
+    bool finish() {
+        if (fd_ < 0) {
+            return false;
+        }
+        if (block_records_ > 0 && !flush_block()) {
+            return false;
+        }
+        const std::uint64_t index_offset = offset_;
+        const ssize_t index_bytes =
+            static_cast<ssize_t>(index_.size() * sizeof(ArchiveBlockIndex));
+        if (index_bytes > 0 &&
+            ::write(fd_, index_.data(), static_cast<std::size_t>(index_bytes)) !=
+                index_bytes) {
+            return false;
+        }
+        ArchiveFileFooter footer{};
+        footer.index_offset = index_offset;
+        footer.block_count = index_.size();
+        std::memcpy(footer.magic, archive_magic, 8);
+        return ::write(fd_, &footer, sizeof(footer)) == sizeof(footer);
+    }
+
+    std::uint64_t block_count() const {
+        return index_.size();
+    }
+
+private:
+    bool flush_block() {
+        ArchiveBlockIndex entry{};
+        entry.first_timestamp_ms = block_first_ts_;
+        entry.last_timestamp_ms = block_last_ts_;
+        entry.offset = offset_;
+        entry.bytes = static_cast<std::uint32_t>(block_.size());
+        entry.records = block_records_;
+        const ssize_t n = static_cast<ssize_t>(block_.size());
+        if (::write(fd_, block_.data(), block_.size()) != n) {
+            return false;
+        }
+        index_.push_back(entry);
+        offset_ += block_.size();
+        block_.clear();
+        block_records_ = 0;
+        return true;
+    }
+
+    int fd_{-1};
+    std::uint64_t offset_{0};
+    std::vector<std::uint8_t> block_;
+    std::uint32_t block_records_{0};
+    std::uint64_t block_first_ts_{0};
+    std::uint64_t block_last_ts_{0};
+    ArchiveDeltaState state_;
+    std::vector<ArchiveBlockIndex> index_;
+};
+
+// アーカイブの読み手。索引だけを常駐させ、ブロックは要求されたものを
+// 都度 pread + 復号する。時間帯の特定は索引上の二分探索で済む。
+class ArchiveReplay {
+public:
+    ArchiveReplay() = default;
+
+    ~ArchiveReplay() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    ArchiveReplay(const ArchiveReplay &) = delete;
+    ArchiveReplay &operator=(const ArchiveReplay &) = delete;
+
+    // 先頭マジックが合わないファイルでは false を返すだけなので、
+    // リング形式との振り分けにそのまま使える。
+    bool open(const char *path) {
+        fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            return false;
+        }
+        ArchiveFileHeader header{};
+        if (::pread(fd_, &header, sizeof(header), 0) != sizeof(header) ||
+            std::memcmp(header.magic, archive_magic, 8) != 0 ||
+            header.version != ARCHIVE_FILE_VERSION) {
+            return false;
+        }
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0 ||
+            static_cast<std::size_t>(st.st_size) < sizeof(ArchiveFileFooter)) {
+            return false;
+        }
+        ArchiveFileFooter footer{};
+        if (::pread(fd_, &footer, sizeof(footer),
+                    st.st_size - static_cast<off_t>(sizeof(footer))) !=
+                sizeof(footer) ||
+            std::memcmp(footer.magic, archive_magic, 8) != 0) {
+            return false;
+        }
+        index_.resize(footer.block_count);
+        const ssize_t index_bytes =
+            static_cast<ssize_t>(footer.block_count * sizeof(ArchiveBlockIndex));
+        return index_bytes == 0 ||
+               ::pread(fd_, index_.data(), static_cast<std::size_t>(index_bytes),
+                       static_cast<off_t>(footer.index_offset)) == index_bytes;
+    }
+
+    std::uint64_t block_count() const {
+        return index_.size();
+    }
+
+    const ArchiveBlockIndex &block(std::uint64_t i) const {
+        return index_[i];
+    }
+
+    // timestamp_ms を含み得る最初のブロック番号を二分探索で返す。
+    std::uint64_t find_block(std::uint64_t timestamp_ms) const {
+        std::uint64_t low = 0;
+        std::uint64_t high = index_.size();
+        while (low < high) {
+            const std::uint64_t mid = (low + high) / 2;
+            if (index_[mid].last_timestamp_ms < timestamp_ms) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // 1ブロックを復号して records へ追記する。破損時は false。
+    bool decode_block(std::uint64_t i, std::vector<HistoryRecord> &records) {
+        const ArchiveBlockIndex &entry = index_[i];
+        scratch_.resize(entry.bytes);
+        if (::pread(fd_, scratch_.data(), entry.bytes,
+                    static_cast<off_t>(entry.offset)) !=
+            static_cast<ssize_t>(entry.bytes)) {
+            return false;
+        }
+        const std::uint8_t *p = scratch_.data();
+        const std::uint8_t *end = p + entry.bytes;
+        ArchiveDeltaState state{};
+        for (std::uint32_t r = 0; r < entry.records; ++r) {
+            HistoryRecord record{};
+            if ((p = archive_decode_record(p, end, state, r == 0, record)) ==
+                nullptr) {
+                return false;
+            }
+            records.push_back(record);
+        }
+        return true;
+    }
+
+private:
+    int fd_{-1};
+    std::vector<ArchiveBlockIndex> index_;
+    std::vector<std::uint8_t> scratch_;
+};
+
+#endif // !_WIN32
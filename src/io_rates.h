@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// /proc/net/dev と /proc/diskstats からの転送量コレクタ。CPU と同じ
+// prev/curr 差分方式だが、1s/10s/60s の3窓を出すため各デバイスに
+// 累積カウンタの小さな固定リングを持たせ、描画側は計算済みレートを
+// 読むだけにする。スナップショット構造体はガード外に置き、非対応
+// 環境でも Sample が空の欄を持てるようにする。
+
+// レートを出す時間窓。インデックスは *_per_sec 配列に対応する。
+constexpr std::size_t rate_window_count = 3;
+constexpr std::uint64_t rate_window_ms[rate_window_count] = {1000, 10000, 60000};
+
+// インターフェイス1つ分のレート。各配列は 1s/10s/60s 窓の値。
+struct NetDeviceRates {
+    char name[16]{};
+    double rx_bytes_per_sec[rate_window_count]{};
+    double tx_bytes_per_sec[rate_window_count]{};
+    double rx_packets_per_sec[rate_window_count]{};
+    double tx_packets_per_sec[rate_window_count]{};
+};
+
+// ブロックデバイス1つ分のレート。IOPS は完了した読み書き要求数。
+struct DiskDeviceRates {
+    char name[16]{};
+    double read_bytes_per_sec[rate_window_count]{};
+    double write_bytes_per_sec[rate_window_count]{};
+    double read_iops[rate_window_count]{};
+    double write_iops[rate_window_count]{};
+};
+
+struct IoRatesSnapshot {
+    static constexpr std::uint32_t max_devices = 16;
+    std::uint32_t net_count{};
+    std::uint32_t disk_count{};
+    NetDeviceRates net[max_devices];
+    DiskDeviceRates disks[max_devices];
+    bool valid{false};
+};
+
+#ifndef _WIN32
+
+#include <cstring>
+
+#include "bulk_parser.h"
+#include "proc_file.h"
+
+class IoRatesSampler {
+public:
+    IoRatesSampler() = default;
+
+    IoRatesSampler(const IoRatesSampler &) = delete;
+    IoRatesSampler &operator=(const IoRatesSampler &) = delete;
+
+    // 両ファイルを一括読みしてデバイスごとの累積値をリングへ積み、
+    // 3窓のレートを out へ書き出す。デバイス数十個でも1パスで済む。
+    void sample(std::uint64_t now_ms, IoRatesSnapshot &out) {
+        out.net_count = 0;
+        out.disk_count = 0;
+        sample_net(now_ms, out);
+        sample_disks(now_ms, out);
+        out.valid = out.net_count > 0 || out.disk_count > 0;
+    }
+
+private:
+    // 1デバイス分の履歴。累積カウンタ4本をタイムスタンプ付きで
+    // 64周期ぶん保持する。1秒周期なら60秒窓までカバーできる。
+    struct DeviceHistory {
+        static constexpr std::size_t ring_capacity = 64;
+        char name[16]{};
+        bool used{false};
+        std::uint32_t head{0};
+        std::uint32_t filled{0};
+        std::uint64_t timestamps_ms[ring_capacity]{};
+        std::uint64_t counters[ring_capacity][4]{};
+    };
+
+    // 名前でデバイス履歴を引く。デバイス数は高々数十なので線形探索で足りる。
+    static DeviceHistory *find_history(DeviceHistory *table, std::size_t capacity,
+                                       const char *name, std::size_t name_length) {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            if (!table[i].used) {
+                std::memcpy(table[i].name, name, name_length);
+                table[i].name[name_length] = '\0';
+                table[i].used = true;
+                return &table[i];
+            }
+            if (std::strncmp(table[i].name, name, name_length) == 0 &&
+                table[i].name[name_length] == '\0') {
+                return &table[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // 累積値をリングへ積み、各窓に最も近い過去エントリとの差分から
+    // レートを求める。窓より履歴が浅い場合は最古エントリで代用する。
+    static void push_and_rate(DeviceHistory &history, std::uint64_t now_ms,
+                              const std::uint64_t counters[4],
+                              double rates[4][rate_window_count]) {
+        history.head = (history.head + 1) % DeviceHistory::ring_capacity;
+        history.timestamps_ms[history.head] = now_ms;
+        std::memcpy(history.counters[history.head], counters,
+                    sizeof(std::uint64_t) * 4);
+        if (history.filled < DeviceHistory::ring_capacity) {
+            ++history.filled;
+        }
+
+        for (std::size_t w = 0; w < rate_window_count; ++w) {
+            // 新しい順に遡り、窓の長さに最も近い age のエントリを選ぶ。
+            std::uint32_t best = history.head;
+            std::uint64_t best_distance = UINT64_MAX;
+            for (std::uint32_t back = 1; back < history.filled; ++back) {
+                const std::uint32_t index =
+                    (history.head + DeviceHistory::ring_capacity - back) %
+                    DeviceHistory::ring_capacity;
+                const std::uint64_t age = now_ms - history.timestamps_ms[index];
+                const std::uint64_t distance = age > rate_window_ms[w]
+                                                   ? age - rate_window_ms[w]
+                                                   : rate_window_ms[w] - age;
+                if (distance <= best_distance) {
+                    best = index;
+                    best_distance = distance;
+                } else {
+                    // age は遡るほど単調増加するので離れ始めたら打ち切る。
+                    break;
+                }
+            }
+            const std::uint64_t elapsed_ms = now_ms - history.timestamps_ms[best];
+            for (std::size_t c = 0; c < 4; ++c) {
+                rates[c][w] =
+                    elapsed_ms == 0
+                        ? 0.0
+                        : static_cast<double>(counters[c] -
+                                              history.counters[best][c]) *
+                              1000.0 / static_cast<double>(elapsed_ms);
+            }
+        }
+    }
+
+    // /proc/net/dev: 2行のヘッダに続き「iface: rx_bytes rx_packets ...
+    // (8欄) tx_bytes tx_packets ...」。必要な4欄だけ読み飛ばしで拾う。
+    void sample_net(std::uint64_t now_ms, IoRatesSnapshot &out) {
+        const ssize_t length = net_dev_.read_all();
+        if (length <= 0) {
+            return;
+        }
+        const char *p = net_dev_.data();
+        const char *end = p + length;
+        while (p < end && out.net_count < IoRatesSnapshot::max_devices) {
+            const char *line_end = find_line_end(p, end);
+            const char *colon =
+                static_cast<const char *>(std::memchr(p, ':', line_end - p));
+            if (colon != nullptr) {
+                const char *name = p;
+                while (name != colon && *name == ' ') {
+                    ++name;
+                }
+                const std::size_t name_length =
+                    static_cast<std::size_t>(colon - name);
+                if (name_length > 0 && name_length < 16) {
+                    std::uint64_t fields[10] = {};
+                    const char *field = colon + 1;
+                    for (std::size_t i = 0; i < 10 && field < line_end; ++i) {
+                        field = parse_uint64_bulk(field, line_end, fields[i]);
+                    }
+                    // rx_bytes, tx_bytes, rx_packets, tx_packets の順で詰める。
+                    const std::uint64_t counters[4] = {fields[0], fields[8],
+                                                       fields[1], fields[9]};
+                    DeviceHistory *history = find_history(
+                        net_history_, IoRatesSnapshot::max_devices, name,
+                        name_length);
+                    if (history != nullptr) {
+                        NetDeviceRates &rates = out.net[out.net_count++];
+                        std::memcpy(rates.name, history->name, sizeof(rates.name));
+                        double values[4][rate_window_count];
+                        push_and_rate(*history, now_ms, counters, values);
+                        std::memcpy(rates.rx_bytes_per_sec, values[0],
+                                    sizeof(values[0]));
+                        std::memcpy(rates.tx_bytes_per_sec, values[1],
+                                    sizeof(values[1]));
+                        std::memcpy(rates.rx_packets_per_sec, values[2],
+                                    sizeof(values[2]));
+                        std::memcpy(rates.tx_packets_per_sec, values[3],
+                                    sizeof(values[3]));
+                    }
+                }
+            }
+            p = line_end + 1;
+        }
+    }
+
+    // /proc/diskstats: major minor name reads merged sectors_rd ms_rd
+    // writes merged sectors_wr ...。セクタは512バイト換算で扱う。
+    void sample_disks(std::uint64_t now_ms, IoRatesSnapshot &out) {
+        const ssize_t length = diskstats_.read_all();
+        if (length <= 0) {
+            return;
+        }
+        const char *p = diskstats_.data();
+        const char *end = p + length;
+        while (p < end && out.disk_count < IoRatesSnapshot::max_devices) {
+            const char *line_end = find_line_end(p, end);
+            std::uint64_t major = 0;
+            std::uint64_t minor = 0;
+            const char *cursor = parse_uint64_bulk(p, line_end, major);
+            cursor = parse_uint64_bulk(cursor, line_end, minor);
+            while (cursor != line_end && *cursor == ' ') {
+                ++cursor;
+            }
+            const char *name = cursor;
+            while (cursor != line_end && *cursor != ' ') {
+                ++cursor;
+            }
+            const std::size_t name_length = static_cast<std::size_t>(cursor - name);
+            // loop/ram デバイスはノイズにしかならないので集計から外す。
+            const bool skip =
+                name_length == 0 || name_length >= 16 ||
+                (name_length >= 4 && std::memcmp(name, "loop", 4) == 0) ||
+                (name_length >= 3 && std::memcmp(name, "ram", 3) == 0);
+            if (!skip) {
+                std::uint64_t fields[7] = {};
+                for (std::size_t i = 0; i < 7 && cursor < line_end; ++i) {
+                    cursor = parse_uint64_bulk(cursor, line_end, fields[i]);
+                }
+                // read_bytes, write_bytes, reads, writes の順で詰める。
+                const std::uint64_t counters[4] = {fields[2] * 512ULL,
+                                                   fields[6] * 512ULL, fields[0],
+                                                   fields[4]};
+                DeviceHistory *history =
+                    find_history(disk_history_, IoRatesSnapshot::max_devices,
+                                 name, name_length);
+                if (history != nullptr) {
+                    DiskDeviceRates &rates = out.disks[out.disk_count++];
+                    std::memcpy(rates.name, history->name, sizeof(rates.name));
+                    double values[4][rate_window_count];
+                    push_and_rate(*history, now_ms, counters, values);
+                    std::memcpy(rates.read_bytes_per_sec, values[0],
+                                sizeof(values[0]));
+                    std::memcpy(rates.write_bytes_per_sec, values[1],
+                                sizeof(values[1]));
+                    std::memcpy(rates.read_iops, values[2], sizeof(values[2]));
+                    std::memcpy(rates.write_iops, values[3], sizeof(values[3]));
+                }
+            }
+            p = line_end + 1;
+        }
+    }
+
+    ProcFile net_dev_{"/proc/net/dev", 16 * 1024};
+    ProcFile diskstats_{"/proc/diskstats", 16 * 1024};
+    DeviceHistory net_history_[IoRatesSnapshot::max_devices];
+    DeviceHistory disk_history_[IoRatesSnapshot::max_devices];
+};
+
+#endif // !_WIN32
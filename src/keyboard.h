@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+// 描画ループへ top 風のキー操作を足すための非ブロッキング入力層。
+// 専用スレッドは立てず、描画までの待ち時間を poll(2) のタイムアウトに
+// 流用することでキー到着に即応しつつ収集周期へは一切触れない。
+
+#ifndef _WIN32
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// stdin を raw モード(非カノニカル・エコー無し)へ切り替え、破棄時に
+// 元へ戻す。端末でない stdin(パイプ・リダイレクト)や EOF 到達後は
+// 単なる sleep に退化し、非対話実行の挙動を変えない。
+class KeyboardInput {
+public:
+    KeyboardInput() {
+        if (::isatty(STDIN_FILENO) != 1) {
+            return;
+        }
+        if (::tcgetattr(STDIN_FILENO, &saved_) != 0) {
+            return;
+        }
+        termios raw = saved_;
+        raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        active_ = ::tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+
+    ~KeyboardInput() {
+        if (active_) {
+            ::tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+        }
+    }
+
+    KeyboardInput(const KeyboardInput &) = delete;
+    KeyboardInput &operator=(const KeyboardInput &) = delete;
+
+    // timeout までキーを待ち、到着すればそのバイトを、なければ -1 を
+    // 返す。キー処理後すぐ次を待てるよう、1回の呼び出しで読むのは
+    // 1バイトだけにしている。
+    int wait_key(std::chrono::milliseconds timeout) {
+        if (!active_) {
+            std::this_thread::sleep_for(timeout);
+            return -1;
+        }
+        pollfd request{STDIN_FILENO, POLLIN, 0};
+        const int ready =
+            ::poll(&request, 1, static_cast<int>(timeout.count()));
+        if (ready <= 0) {
+            return -1;
+        }
+        if ((request.revents & POLLIN) == 0) {
+            // POLLHUP 等。ビジーループに陥らないよう入力を打ち切る。
+            disable();
+            return -1;
+        }
+        char key = 0;
+        const ssize_t n = ::read(STDIN_FILENO, &key, 1);
+        if (n <= 0) {
+            disable();
+            return -1;
+        }
+        return static_cast<unsigned char>(key);
+    }
+
+private:
+    void disable() {
+        if (active_) {
+            ::tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+            active_ = false;
+        }
+    }
+
+    termios saved_{};
+    bool active_{false};
+};
+
+#else
+
+// Windows ではコンソール入力の非ブロッキング化を持たないため、
+// 待つだけの空実装とする。キー操作は Linux 専用機能となる。
+class KeyboardInput {
+public:
+    KeyboardInput() = default;
+
+    KeyboardInput(const KeyboardInput &) = delete;
+    KeyboardInput &operator=(const KeyboardInput &) = delete;
+
+    int wait_key(std::chrono::milliseconds timeout) {
+        std::this_thread::sleep_for(timeout);
+        return -1;
+    }
+};
+
+#endif // !_WIN32
@@ -1,48 +1,41 @@
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <filesystem>
-#include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <ctime>
 
 #ifdef _WIN32
 #include <windows.h>
-#include <psapi.h>
-#else
-#include <unistd.h>
 #endif
 
-namespace {
-struct CpuSnapshot {
-    std::uint64_t idle_ticks{};
-    std::uint64_t total_ticks{};
-};
-
-struct MemoryStatus {
-    std::uint64_t total_bytes{};
-    std::uint64_t available_bytes{};
-    bool valid{false};
-};
-
-struct TaskSummary {
-    std::size_t total{};
-    bool valid{false};
-};
-
-struct LoadAverages {
-    double one{};
-    double five{};
-    double fifteen{};
-    bool valid{false};
-};
+#include "cgroup_sampler.h"
+#include "diff_renderer.h"
+#include "fleet.h"
+#include "frame_buffer.h"
+#include "gpu_sampler.h"
+#include "history_archive.h"
+#include "io_rates.h"
+#include "keyboard.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "numa_sampler.h"
+#include "platform_sampler.h"
+#include "recorder.h"
+#include "sparkline.h"
+#include "spsc_ring.h"
+#include "stage_stats.h"
+#include "text_format.h"
+#include "top_n.h"
 
+namespace {
 #ifdef _WIN32
 // WindowsコンソールにANSIエスケープを許可する。
 // VTモードを有効化できない環境では false を返し画面更新を諦める。
@@ -62,323 +55,1465 @@ bool enable_virtual_terminal_processing() {
 }
 #endif
 
-// 端末をクリアしカーソルを先頭へ戻す。
-// 毎秒呼び出して最新状態だけを表示するための制御。
-void clear_screen() {
-    std::cout << "\x1b[2J\x1b[H";
-}
+// 収集スレッドが詰める1周期分の計測結果。描画側はこれだけを参照する。
+struct Sample {
+    double cpu_usage{};
+    std::vector<double> core_usages;
+    MemoryStatus memory;
+    TaskSummary tasks;
+    LoadAverages loads;
+    std::uint64_t uptime{};
+    // PSI。取得できない環境では各リソースが valid=false のままとなる。
+    PressureSet pressure;
+    // GPU。NVML が無いホストでは valid=false のままとなる。
+    GpuSnapshot gpu;
+    // ネットワーク/ディスクの窓別レート。Linux でのみ埋まる。
+    IoRatesSnapshot io;
+    // 所属 cgroup のクォータ相対使用量。cgroup v2 の Linux でのみ埋まる。
+    CgroupStatus cgroup;
+    // NUMA ノード別メモリ。単一ノード/非対応ホストでは valid=false。
+    NumaSnapshot numa;
+    // このサンプルがバースト捕捉中に採られたなら true。表示用。
+    bool burst{false};
+    // %CPU降順の表示対象。並べ替えは描画側で最新サンプルに対してのみ行う。
+    // サンプラがプロセス表を提供しない環境では空のままとなる。
+    std::vector<ProcessInfo> processes;
+};
 
-#ifdef _WIN32
-// FILETIME を 64bit 値へ詰め替えるヘルパー。
-// CPU 時刻計算で扱いやすいよう整数化する。
-std::uint64_t file_time_to_uint64(const FILETIME &ft) {
-    ULARGE_INTEGER li;
-    li.LowPart = ft.dwLowDateTime;
-    li.HighPart = ft.dwHighDateTime;
-    return li.QuadPart;
-}
-#endif
+// 収集側と描画側で共有する状態。リングは大きいので静的に確保する。
+using SampleRing = SpscRing<Sample, 1024>;
 
-// OS 別にCPUの稼働/アイドル時間を取得してスナップショットに詰める。
-// 取得に失敗した場合は false を返し外側で終了を促す。
-bool sample_cpu(CpuSnapshot &snapshot) {
-#ifdef _WIN32
-    FILETIME idle{}, kernel{}, user{};
-    if (!GetSystemTimes(&idle, &kernel, &user)) {
+// バースト捕捉のしきい値条件。毎周期サンプル値と比較され、成立すると
+// 収集が一定時間だけ最大レートへ切り替わる。
+struct TriggerCondition {
+    enum class Metric {
+        cpu_usage,
+        mem_available,
+        load_one,
+        tasks_total,
+    };
+
+    Metric metric{Metric::cpu_usage};
+    bool greater{true};
+    double threshold{0.0};
+};
+
+// "cpu_usage>90" "mem_available<2G" 形式を解析する。値の K/M/G 接尾辞は
+// 1024 の冪として扱う。不正な式は false。
+bool parse_trigger(const char *text, TriggerCondition &out) {
+    const char *op = std::strpbrk(text, "<>");
+    if (op == nullptr || op == text) {
         return false;
     }
-    const std::uint64_t idle_ticks = file_time_to_uint64(idle);
-    const std::uint64_t kernel_ticks = file_time_to_uint64(kernel);
-    const std::uint64_t user_ticks = file_time_to_uint64(user);
+    out.greater = *op == '>';
 
-    snapshot.idle_ticks = idle_ticks;
-    snapshot.total_ticks = kernel_ticks + user_ticks;
-    return true;
-#else
-    std::ifstream stat("/proc/stat");
-    if (!stat.is_open()) {
-        return false;
+    std::string name(text, static_cast<std::size_t>(op - text));
+    while (!name.empty() && name.back() == ' ') {
+        name.pop_back();
     }
-    std::string line;
-    if (!std::getline(stat, line)) {
+    for (char &c : name) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (name == "cpu" || name == "cpu_usage") {
+        out.metric = TriggerCondition::Metric::cpu_usage;
+    } else if (name == "mem_available" || name == "memavailable") {
+        out.metric = TriggerCondition::Metric::mem_available;
+    } else if (name == "load1" || name == "load") {
+        out.metric = TriggerCondition::Metric::load_one;
+    } else if (name == "tasks") {
+        out.metric = TriggerCondition::Metric::tasks_total;
+    } else {
         return false;
     }
-    std::istringstream iss(line);
-    std::string cpu_label;
-    iss >> cpu_label;
-    if (cpu_label != "cpu") {
+
+    char *suffix = nullptr;
+    out.threshold = std::strtod(op + 1, &suffix);
+    if (suffix == op + 1) {
         return false;
     }
+    switch (*suffix) {
+    case 'K':
+    case 'k':
+        out.threshold *= 1024.0;
+        break;
+    case 'M':
+    case 'm':
+        out.threshold *= 1024.0 * 1024.0;
+        break;
+    case 'G':
+    case 'g':
+        out.threshold *= 1024.0 * 1024.0 * 1024.0;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
 
-    std::uint64_t values[10] = {};
-    for (int i = 0; i < 10 && iss; ++i) {
-        iss >> values[i];
+double trigger_metric_value(const Sample &sample, TriggerCondition::Metric metric) {
+    switch (metric) {
+    case TriggerCondition::Metric::cpu_usage:
+        return sample.cpu_usage;
+    case TriggerCondition::Metric::mem_available:
+        return static_cast<double>(sample.memory.available_bytes);
+    case TriggerCondition::Metric::load_one:
+        return sample.loads.one;
+    case TriggerCondition::Metric::tasks_total:
+        return static_cast<double>(sample.tasks.total);
     }
+    return 0.0;
+}
 
-    std::uint64_t total = 0;
-    for (int i = 0; i < 10; ++i) {
-        total += values[i];
+bool triggers_fired(const std::vector<TriggerCondition> &triggers,
+                    const Sample &sample) {
+    for (const TriggerCondition &trigger : triggers) {
+        const double value = trigger_metric_value(sample, trigger.metric);
+        if (trigger.greater ? value > trigger.threshold
+                            : value < trigger.threshold) {
+            return true;
+        }
     }
-    const std::uint64_t idle = values[3] + values[4];
+    return false;
+}
 
-    snapshot.idle_ticks = idle;
-    snapshot.total_ticks = total;
-    return true;
-#endif
+#ifndef _WIN32
+std::uint64_t wall_clock_ms() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
 }
 
-// 直近2回のCPUスナップショットの差分から使用率を算出する。
-// 分母がゼロの場合は0%として扱い例外的なスパイクを避ける。
-double compute_cpu_usage(const CpuSnapshot &prev, const CpuSnapshot &curr) {
-    const std::uint64_t idle_delta = curr.idle_ticks - prev.idle_ticks;
-    const std::uint64_t total_delta = curr.total_ticks - prev.total_ticks;
-    if (total_delta == 0) {
-        return 0.0;
+// サンプルを記録ファイル用の固定長レコードへ詰め替える。
+// コア別・プロセス別の可変長情報は記録対象に含めない。
+HistoryRecord make_history_record(const Sample &sample) {
+    HistoryRecord record{};
+    record.timestamp_ms = wall_clock_ms();
+    record.uptime_seconds = sample.uptime;
+    record.cpu_usage = sample.cpu_usage;
+    if (sample.memory.valid) {
+        record.mem_total_bytes = sample.memory.total_bytes;
+        record.mem_available_bytes = sample.memory.available_bytes;
+        record.flags |= record_flag_memory;
     }
-    const std::uint64_t active_delta = total_delta - idle_delta;
-    return static_cast<double>(active_delta) * 100.0 / static_cast<double>(total_delta);
+    if (sample.tasks.valid) {
+        record.tasks_total = static_cast<std::uint32_t>(sample.tasks.total);
+        record.tasks_running = static_cast<std::uint32_t>(sample.tasks.running);
+        record.tasks_sleeping = static_cast<std::uint32_t>(sample.tasks.sleeping);
+        record.tasks_stopped = static_cast<std::uint32_t>(sample.tasks.stopped);
+        record.tasks_zombie = static_cast<std::uint32_t>(sample.tasks.zombie);
+        record.flags |= record_flag_tasks;
+        if (sample.tasks.has_states) {
+            record.flags |= record_flag_task_states;
+        }
+    }
+    if (sample.loads.valid) {
+        record.load_one = static_cast<float>(sample.loads.one);
+        record.load_five = static_cast<float>(sample.loads.five);
+        record.load_fifteen = static_cast<float>(sample.loads.fifteen);
+        record.flags |= record_flag_loads;
+    }
+    return record;
 }
 
-// 利用可能メモリと総容量を取得し、MiB表示に利用する。
-// 取得できない環境では valid を false のままとして扱う。
-MemoryStatus sample_memory() {
-    MemoryStatus status{};
-#ifdef _WIN32
-    MEMORYSTATUSEX memory_info{};
-    memory_info.dwLength = sizeof(memory_info);
-    if (GlobalMemoryStatusEx(&memory_info)) {
-        status.total_bytes = memory_info.ullTotalPhys;
-        status.available_bytes = memory_info.ullAvailPhys;
-        status.valid = true;
+// 記録レコードを描画用サンプルへ復元する。--replay の描画経路で使う。
+Sample sample_from_record(const HistoryRecord &record) {
+    Sample sample{};
+    sample.cpu_usage = record.cpu_usage;
+    sample.uptime = record.uptime_seconds;
+    if (record.flags & record_flag_memory) {
+        sample.memory.total_bytes = record.mem_total_bytes;
+        sample.memory.available_bytes = record.mem_available_bytes;
+        sample.memory.valid = true;
     }
-#else
-    std::ifstream meminfo("/proc/meminfo");
-    if (!meminfo.is_open()) {
-        return status;
-    }
-    std::string key;
-    std::uint64_t value = 0;
-    std::string unit;
-    std::uint64_t mem_total = 0;
-    std::uint64_t mem_available = 0;
-    while (meminfo >> key >> value >> unit) {
-        if (key == "MemTotal:") {
-            mem_total = value * 1024;
-        } else if (key == "MemAvailable:") {
-            mem_available = value * 1024;
-        }
-        if (mem_total && mem_available) {
-            break;
-        }
-    }
-    if (mem_total) {
-        status.total_bytes = mem_total;
-        status.available_bytes = mem_available;
-        status.valid = true;
+    if (record.flags & record_flag_tasks) {
+        sample.tasks.total = record.tasks_total;
+        sample.tasks.running = record.tasks_running;
+        sample.tasks.sleeping = record.tasks_sleeping;
+        sample.tasks.stopped = record.tasks_stopped;
+        sample.tasks.zombie = record.tasks_zombie;
+        sample.tasks.has_states = (record.flags & record_flag_task_states) != 0;
+        sample.tasks.valid = true;
+    }
+    if (record.flags & record_flag_loads) {
+        sample.loads.one = record.load_one;
+        sample.loads.five = record.load_five;
+        sample.loads.fifteen = record.load_fifteen;
+        sample.loads.valid = true;
     }
+    return sample;
+}
 #endif
-    return status;
+
+#ifndef _WIN32
+// サンプルを Prometheus テキスト形式へ整形する。フレームバッファで
+// 組み立ててから公開用の文字列として切り出す。
+std::string format_prometheus(const Sample &sample, FrameBuffer &scratch) {
+    scratch.clear();
+    scratch.append("# TYPE benchmark_cpu_usage_percent gauge\n");
+    scratch.append("benchmark_cpu_usage_percent ");
+    scratch.append_fixed(sample.cpu_usage, 3);
+    scratch.append('\n');
+    scratch.append("# TYPE benchmark_cpu_core_usage_percent gauge\n");
+    for (std::size_t i = 0; i < sample.core_usages.size(); ++i) {
+        scratch.append("benchmark_cpu_core_usage_percent{core=\"");
+        scratch.append_uint(i);
+        scratch.append("\"} ");
+        scratch.append_fixed(sample.core_usages[i], 3);
+        scratch.append('\n');
+    }
+    if (sample.memory.valid) {
+        scratch.append("# TYPE benchmark_memory_bytes gauge\n");
+        const struct {
+            const char *label;
+            std::uint64_t value;
+        } fields[] = {
+            {"total", sample.memory.total_bytes},
+            {"available", sample.memory.available_bytes},
+            {"buffers", sample.memory.buffers_bytes},
+            {"cached", sample.memory.cached_bytes},
+            {"dirty", sample.memory.dirty_bytes},
+            {"slab", sample.memory.slab_bytes},
+            {"swap_total", sample.memory.swap_total_bytes},
+            {"swap_free", sample.memory.swap_free_bytes},
+        };
+        for (const auto &field : fields) {
+            scratch.append("benchmark_memory_bytes{kind=\"");
+            scratch.append(field.label);
+            scratch.append("\"} ");
+            scratch.append_uint(field.value);
+            scratch.append('\n');
+        }
+    }
+    if (sample.tasks.valid) {
+        scratch.append("# TYPE benchmark_tasks gauge\n");
+        const struct {
+            const char *label;
+            std::size_t value;
+        } states[] = {
+            {"total", sample.tasks.total},
+            {"running", sample.tasks.running},
+            {"sleeping", sample.tasks.sleeping},
+            {"stopped", sample.tasks.stopped},
+            {"zombie", sample.tasks.zombie},
+        };
+        for (const auto &state : states) {
+            scratch.append("benchmark_tasks{state=\"");
+            scratch.append(state.label);
+            scratch.append("\"} ");
+            scratch.append_uint(state.value);
+            scratch.append('\n');
+        }
+    }
+    if (sample.loads.valid) {
+        scratch.append("# TYPE benchmark_load_average gauge\n");
+        scratch.append("benchmark_load_average{period=\"1m\"} ");
+        scratch.append_fixed(sample.loads.one, 2);
+        scratch.append("\nbenchmark_load_average{period=\"5m\"} ");
+        scratch.append_fixed(sample.loads.five, 2);
+        scratch.append("\nbenchmark_load_average{period=\"15m\"} ");
+        scratch.append_fixed(sample.loads.fifteen, 2);
+        scratch.append('\n');
+    }
+    scratch.append("# TYPE benchmark_uptime_seconds counter\n");
+    scratch.append("benchmark_uptime_seconds ");
+    scratch.append_uint(sample.uptime);
+    scratch.append('\n');
+    return std::string(scratch.data(), scratch.size());
 }
+#endif
 
-// 稼働中プロセス数を数え上げ、Tasks 行に利用する。
-// WindowsはAPI列挙、Linuxは /proc を巡回して集計する。
-TaskSummary sample_tasks() {
-    TaskSummary summary{};
-#ifdef _WIN32
-    std::vector<DWORD> process_ids(1024);
-    DWORD bytes_returned = 0;
-    while (true) {
-        if (!EnumProcesses(process_ids.data(),
-                           static_cast<DWORD>(process_ids.size() * sizeof(DWORD)),
-                           &bytes_returned)) {
-            return summary;
+// 収集器ごとの適応バックオフ。値が安定している収集器は実行周期を
+// 指数的に間引き(最大で基本周期の32倍)、変化を検知したら即座に
+// 全速へ戻す。タスク走査のような高価な収集器をCPUサンプラの周期で
+// 回さないための仕組み。
+struct AdaptiveSchedule {
+    static constexpr std::uint32_t stable_threshold = 8;
+    static constexpr std::uint32_t max_divisor = 32;
+
+    std::uint32_t divisor{1};
+    std::uint32_t stable_cycles{0};
+    std::uint32_t countdown{0};
+
+    // この周期で収集を実行すべきなら true。実行しない周期は待ち数を減らす。
+    bool due() {
+        if (countdown == 0) {
+            return true;
         }
-        const std::size_t count = bytes_returned / sizeof(DWORD);
-        if (count < process_ids.size()) {
-            summary.total = count;
-            summary.valid = true;
-            return summary;
+        --countdown;
+        return false;
+    }
+
+    // 収集結果の変化有無を報告し、次回実行までの間隔を決める。
+    void on_result(bool changed) {
+        if (changed) {
+            divisor = 1;
+            stable_cycles = 0;
+        } else if (++stable_cycles >= stable_threshold && divisor < max_divisor) {
+            divisor *= 2;
+            stable_cycles = 0;
         }
-        process_ids.resize(process_ids.size() * 2);
+        countdown = divisor - 1;
     }
+};
+
+// メモリ状態の「変化」の判定。利用可能量やスワップはページキャッシュで
+// 常に微動するため、4MiB を超えて動いた場合のみ変化とみなす。
+bool memory_changed(const MemoryStatus &a, const MemoryStatus &b) {
+    const auto moved = [](std::uint64_t x, std::uint64_t y) {
+        const std::uint64_t delta = x > y ? x - y : y - x;
+        return delta > 4ULL * 1024 * 1024;
+    };
+    return a.valid != b.valid || moved(a.available_bytes, b.available_bytes) ||
+           moved(a.swap_free_bytes, b.swap_free_bytes) ||
+           moved(a.dirty_bytes, b.dirty_bytes);
+}
+
+bool tasks_changed(const TaskSummary &a, const TaskSummary &b) {
+    return a.valid != b.valid || a.total != b.total || a.running != b.running ||
+           a.sleeping != b.sleeping || a.stopped != b.stopped ||
+           a.zombie != b.zombie;
+}
+
+bool loads_changed(const LoadAverages &a, const LoadAverages &b) {
+    return a.valid != b.valid || a.one != b.one || a.five != b.five ||
+           a.fifteen != b.fifteen;
+}
+
+// 指定周期で全メトリクスをサンプリングしリングへ押し込む収集ループ本体。
+// 端末出力と同居させないことで、遅いSSH端末が収集を止める問題を避ける。
+void collection_loop(std::atomic<std::int64_t> &interval_ms,
+                     PlatformSampler &sampler,
+                     CpuSnapshot previous_snapshot,
+                     SampleRing &ring,
+                     std::atomic<bool> &failed,
+                     StageStats &stats,
+                     const char *record_path,
+                     const char *publish_destination,
+                     const char *cgroup_path,
+                     std::vector<TriggerCondition> triggers,
+                     std::chrono::milliseconds burst_duration,
+#ifndef _WIN32
+                     MetricsServer *metrics
 #else
-    std::size_t count = 0;
-    try {
-        for (const auto &entry : std::filesystem::directory_iterator("/proc")) {
-            if (!entry.is_directory()) {
-                continue;
+                     void *metrics
+#endif
+) {
+#ifndef _WIN32
+    FrameBuffer exposition_scratch;
+    // cgroup v2 階層が無いホストでは init が失敗し、表示ごと省かれる。
+    CgroupSampler cgroup_sampler;
+    const bool cgroup_ready = cgroup_sampler.init(cgroup_path);
+    // GPU は NVML 呼び出しのブロックを CPU 周期に持ち込まないよう、
+    // コレクタ自身のスレッドで1秒周期のポーリングを回す。ここでの
+    // 読み取りはシーケンスロックのコピーだけで待ちを含まない。
+    GpuSampler gpu_sampler;
+    const bool gpu_ready = gpu_sampler.start(std::chrono::seconds(1));
+    IoRatesSampler io_sampler;
+    // NUMA ノードファイルの発見はここで一度だけ行われる。
+    NumaSampler numa_sampler;
+    FleetPublisher publisher;
+    if (publish_destination != nullptr && !publisher.open(publish_destination)) {
+        failed.store(true, std::memory_order_release);
+        return;
+    }
+    // 記録器は収集スレッド専有。1Hz で1日分に相当するスロットを確保する。
+    RingRecorder recorder;
+    if (record_path != nullptr) {
+        if (!recorder.open_for_write(record_path, 86400)) {
+            failed.store(true, std::memory_order_release);
+            return;
+        }
+    }
+#else
+    (void)record_path;
+    (void)publish_destination;
+    (void)cgroup_path;
+    (void)metrics;
+#endif
+    // 適応スケジューラの状態。間引いた周期には直近の取得値を使い回す。
+    AdaptiveSchedule memory_schedule;
+    AdaptiveSchedule tasks_schedule;
+    AdaptiveSchedule loads_schedule;
+    MemoryStatus last_memory{};
+    TaskSummary last_tasks{};
+    LoadAverages last_loads{};
+    std::vector<ProcessInfo> last_processes;
+    std::uint64_t ticks_at_last_scan = previous_snapshot.total_ticks;
+    // 周期内の一時確保はここから切り出し、周期末尾に O(1) で巻き戻す。
+    TickArena tick_arena;
+
+    std::chrono::steady_clock::time_point burst_until{};
+    // 基準周期はキー操作で実行中に変わるため、毎周期 atomic から読み直す。
+    auto active_interval =
+        std::chrono::milliseconds(interval_ms.load(std::memory_order_relaxed));
+    auto next_tick = std::chrono::steady_clock::now() + active_interval;
+    while (true) {
+        std::this_thread::sleep_until(next_tick);
+        next_tick += active_interval;
+
+        // 周期内の /proc 読み取りをまとめて先読みする(対応環境のみ)。
+        sampler.begin_tick();
+
+        CpuSnapshot current_snapshot{};
+        {
+            StageTimer timer(stats, Stage::cpu);
+            if (!sampler.sample_cpu(current_snapshot)) {
+                failed.store(true, std::memory_order_release);
+                return;
             }
-            const auto name = entry.path().filename().string();
-            if (!name.empty() && std::all_of(name.begin(), name.end(),
-                                             [](unsigned char c) { return std::isdigit(c) != 0; })) {
-                ++count;
+        }
+
+        Sample sample{};
+        sample.cpu_usage = compute_cpu_usage(previous_snapshot, current_snapshot);
+        const std::uint64_t total_ticks = current_snapshot.total_ticks;
+        const std::size_t core_count =
+            std::min(previous_snapshot.cores.size(), current_snapshot.cores.size());
+        sample.core_usages.reserve(core_count);
+        for (std::size_t i = 0; i < core_count; ++i) {
+            sample.core_usages.push_back(
+                compute_core_usage(previous_snapshot.cores[i], current_snapshot.cores[i]));
+        }
+        previous_snapshot = std::move(current_snapshot);
+
+        if (memory_schedule.due()) {
+            StageTimer timer(stats, Stage::memory);
+            sample.memory = sampler.sample_memory();
+            memory_schedule.on_result(memory_changed(sample.memory, last_memory));
+            last_memory = sample.memory;
+        } else {
+            sample.memory = last_memory;
+        }
+
+        if (tasks_schedule.due()) {
+            StageTimer timer(stats, Stage::tasks);
+            // 走査を間引いた分だけチック差分が積み上がるので、%CPU の
+            // 正規化には前回走査時点からの差分を使う。
+            sampler.sample_tasks(sample.tasks, sample.processes,
+                                 total_ticks - ticks_at_last_scan,
+                                 std::max<std::size_t>(core_count, 1), tick_arena);
+            ticks_at_last_scan = total_ticks;
+            tasks_schedule.on_result(tasks_changed(sample.tasks, last_tasks));
+            last_tasks = sample.tasks;
+            last_processes = sample.processes;
+        } else {
+            sample.tasks = last_tasks;
+            sample.processes = last_processes;
+            // 走査を間引いた周期は fork/exit イベントで総数だけ追従させる。
+            if (sampler.refresh_task_counts(sample.tasks)) {
+                last_tasks = sample.tasks;
             }
         }
-        summary.total = count;
-        summary.valid = true;
-    } catch (const std::exception &) {
-        // Leave summary invalid if /proc is unavailable.
-    }
+
+        if (loads_schedule.due()) {
+            StageTimer timer(stats, Stage::loads);
+            sample.loads = sampler.sample_load_averages();
+            loads_schedule.on_result(loads_changed(sample.loads, last_loads));
+            last_loads = sample.loads;
+        } else {
+            sample.loads = last_loads;
+        }
+        sample.pressure = sampler.sample_pressure();
+        sample.uptime = sampler.uptime_seconds();
+#ifndef _WIN32
+        if (gpu_ready) {
+            gpu_sampler.read(sample.gpu);
+        }
+        if (cgroup_ready) {
+            sample.cgroup = cgroup_sampler.sample();
+        }
+        if (numa_sampler.valid()) {
+            numa_sampler.sample(sample.numa);
+        }
+        {
+            StageTimer timer(stats, Stage::io);
+            const std::uint64_t now_ms = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+            io_sampler.sample(now_ms, sample.io);
+        }
 #endif
-    return summary;
+
+        // しきい値評価。成立のたびに窓を延長するので、条件が続く限り
+        // バーストは切れ目なく継続し、収まれば基準周期へ戻る。
+        const auto base_interval =
+            std::chrono::milliseconds(interval_ms.load(std::memory_order_relaxed));
+        active_interval = base_interval;
+        if (!triggers.empty()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (triggers_fired(triggers, sample)) {
+                burst_until = now + burst_duration;
+            }
+            sample.burst = now < burst_until;
+            if (sample.burst) {
+                // バースト中の刻み。基準が既に 10ms 未満ならそれ以上縮めない。
+                active_interval =
+                    std::min(base_interval, std::chrono::milliseconds(10));
+            }
+        }
+
+#ifndef _WIN32
+        if (recorder.valid() || publisher.valid()) {
+            const HistoryRecord record = make_history_record(sample);
+            if (recorder.valid()) {
+                recorder.append(record);
+            }
+            if (publisher.valid()) {
+                publisher.publish(record);
+            }
+        }
+        if (metrics != nullptr && metrics->running()) {
+            metrics->publish(format_prometheus(sample, exposition_scratch));
+        }
+#endif
+
+        // 満杯時は新しいサンプルを落とす。描画側は毎回全量を吸い出すので
+        // 実際に落ちるのは描画が長時間停止した場合に限られる。
+        ring.push(std::move(sample));
+        tick_arena.reset();
+    }
 }
 
-// システムのロードアベレージを取得する。
-// Windowsでは取得不能なので valid=false として N/A 表示にする。
-LoadAverages sample_load_averages() {
-    LoadAverages averages{};
-#ifdef _WIN32
-    averages.valid = false;
-#else
-    double loads[3] = {};
-    if (getloadavg(loads, 3) == 3) {
-        averages.one = loads[0];
-        averages.five = loads[1];
-        averages.fifteen = loads[2];
-        averages.valid = true;
+#ifndef _WIN32
+// フリート集約ビューを1フレーム分組み立てる。%CPU 降順で、一定時間
+// 音沙汰の無いホストは stale 扱いの印を付けて末尾判断はしない。
+void render_fleet(const FleetAggregator &aggregator, std::uint64_t now_ms,
+                  FrameBuffer &frame, std::vector<const FleetHost *> &scratch) {
+    scratch.clear();
+    for (const FleetHost &host : aggregator.hosts()) {
+        if (host.used) {
+            scratch.push_back(&host);
+        }
+    }
+    std::sort(scratch.begin(), scratch.end(),
+              [](const FleetHost *a, const FleetHost *b) {
+                  return a->last.cpu_usage > b->last.cpu_usage;
+              });
+
+    frame.clear();
+    frame.append("fleet - ");
+    frame.append_uint(scratch.size());
+    frame.append(" hosts\n\n");
+    frame.append("HOST                             %CPU   MEM_USED(MiB)  TASKS  LOAD1  AGE(s)\n");
+    for (const FleetHost *host : scratch) {
+        const std::size_t name_length = std::strlen(host->hostname);
+        frame.append(host->hostname);
+        for (std::size_t i = name_length; i < 32; ++i) {
+            frame.append(' ');
+        }
+        frame.append(' ');
+        frame.append_fixed_padded(host->last.cpu_usage, 1, 5);
+        frame.append("  ");
+        const std::uint64_t used =
+            host->last.mem_total_bytes > host->last.mem_available_bytes
+                ? host->last.mem_total_bytes - host->last.mem_available_bytes
+                : 0ULL;
+        frame.append_fixed_padded(static_cast<double>(used) / (1024.0 * 1024.0), 1, 14);
+        frame.append("  ");
+        frame.append_uint_padded(host->last.tasks_total, 5);
+        frame.append("  ");
+        frame.append_fixed_padded(host->last.load_one, 2, 5);
+        frame.append("  ");
+        frame.append_uint_padded(
+            now_ms >= host->last_seen_ms ? (now_ms - host->last_seen_ms) / 1000 : 0, 6);
+        frame.append('\n');
     }
+}
 #endif
-    return averages;
+
+// プロセス表に表示する最大行数。top と同程度の画面量に揃える。
+constexpr std::size_t process_display_rows = 20;
+
+// 機械可読出力の形式。screen は従来の top 風画面を指す。
+enum class OutputMode {
+    screen,
+    json,
+    csv,
+};
+
+// 現在の壁時計時刻をミリ秒で返す。ストリーム出力のタイムスタンプ用。
+std::uint64_t output_timestamp_ms() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
 }
 
-// システムの稼働秒数を取得し uptime 表示に使用する。
-// Windows は GetTickCount64、Linux は /proc/uptime を参照する。
-std::uint64_t uptime_seconds() {
-#ifdef _WIN32
-    return static_cast<std::uint64_t>(GetTickCount64() / 1000ULL);
-#else
-    std::ifstream uptime_file("/proc/uptime");
-    if (!uptime_file.is_open()) {
-        return 0;
+// 1サンプルを1行の NDJSON として追記する。数値整形は FrameBuffer の
+// to_chars 経路のみを使い、一時文字列を作らない。
+void append_sample_json(const Sample &sample, FrameBuffer &out) {
+    out.append("{\"ts_ms\":");
+    out.append_uint(output_timestamp_ms());
+    out.append(",\"cpu\":");
+    out.append_fixed(sample.cpu_usage, 3);
+    out.append(",\"cores\":[");
+    for (std::size_t i = 0; i < sample.core_usages.size(); ++i) {
+        if (i > 0) {
+            out.append(',');
+        }
+        out.append_fixed(sample.core_usages[i], 1);
     }
-    double uptime = 0.0;
-    uptime_file >> uptime;
-    return static_cast<std::uint64_t>(uptime);
-#endif
+    out.append("],\"mem_total\":");
+    out.append_uint(sample.memory.total_bytes);
+    out.append(",\"mem_available\":");
+    out.append_uint(sample.memory.available_bytes);
+    out.append(",\"swap_total\":");
+    out.append_uint(sample.memory.swap_total_bytes);
+    out.append(",\"swap_free\":");
+    out.append_uint(sample.memory.swap_free_bytes);
+    out.append(",\"tasks\":");
+    out.append_uint(sample.tasks.total);
+    out.append(",\"running\":");
+    out.append_uint(sample.tasks.running);
+    out.append(",\"sleeping\":");
+    out.append_uint(sample.tasks.sleeping);
+    out.append(",\"stopped\":");
+    out.append_uint(sample.tasks.stopped);
+    out.append(",\"zombie\":");
+    out.append_uint(sample.tasks.zombie);
+    out.append(",\"load1\":");
+    out.append_fixed(sample.loads.one, 2);
+    out.append(",\"load5\":");
+    out.append_fixed(sample.loads.five, 2);
+    out.append(",\"load15\":");
+    out.append_fixed(sample.loads.fifteen, 2);
+    out.append(",\"psi_cpu\":");
+    out.append_fixed(sample.pressure.cpu.some_avg10, 2);
+    out.append(",\"psi_mem\":");
+    out.append_fixed(sample.pressure.memory.some_avg10, 2);
+    out.append(",\"psi_io\":");
+    out.append_fixed(sample.pressure.io.some_avg10, 2);
+    out.append(",\"uptime\":");
+    out.append_uint(sample.uptime);
+    out.append("}\n");
+}
+
+// CSV の列見出し。列順は append_sample_csv と一致させること。
+void append_csv_header(FrameBuffer &out) {
+    out.append("ts_ms,cpu,mem_total,mem_available,swap_total,swap_free,"
+               "tasks,running,sleeping,stopped,zombie,"
+               "load1,load5,load15,psi_cpu,psi_mem,psi_io,uptime\n");
 }
 
-// 秒数を「日, 時:分」形式へ整形し top 風の文字列を返す。
-// 1分未満の短時間は "XXs" として短く表示する。
-std::string format_uptime(std::uint64_t seconds) {
-    std::ostringstream oss;
-    if (seconds < 60) {
-        oss << seconds << "s";
-        return oss.str();
+void append_sample_csv(const Sample &sample, FrameBuffer &out) {
+    out.append_uint(output_timestamp_ms());
+    out.append(',');
+    out.append_fixed(sample.cpu_usage, 3);
+    out.append(',');
+    out.append_uint(sample.memory.total_bytes);
+    out.append(',');
+    out.append_uint(sample.memory.available_bytes);
+    out.append(',');
+    out.append_uint(sample.memory.swap_total_bytes);
+    out.append(',');
+    out.append_uint(sample.memory.swap_free_bytes);
+    out.append(',');
+    out.append_uint(sample.tasks.total);
+    out.append(',');
+    out.append_uint(sample.tasks.running);
+    out.append(',');
+    out.append_uint(sample.tasks.sleeping);
+    out.append(',');
+    out.append_uint(sample.tasks.stopped);
+    out.append(',');
+    out.append_uint(sample.tasks.zombie);
+    out.append(',');
+    out.append_fixed(sample.loads.one, 2);
+    out.append(',');
+    out.append_fixed(sample.loads.five, 2);
+    out.append(',');
+    out.append_fixed(sample.loads.fifteen, 2);
+    out.append(',');
+    out.append_fixed(sample.pressure.cpu.some_avg10, 2);
+    out.append(',');
+    out.append_fixed(sample.pressure.memory.some_avg10, 2);
+    out.append(',');
+    out.append_fixed(sample.pressure.io.some_avg10, 2);
+    out.append(',');
+    out.append_uint(sample.uptime);
+    out.append('\n');
+}
+
+// 表示対象のサンプル値をスパークライン履歴へ押し込む。正規化は
+// ここで済ませ、描画側はグリフ参照だけになる。
+void push_trends(const Sample &sample, SparklineSet &trends) {
+    trends.cpu.push(sample.cpu_usage);
+    if (sample.memory.valid && sample.memory.total_bytes > 0) {
+        const std::uint64_t used =
+            sample.memory.total_bytes > sample.memory.available_bytes
+                ? sample.memory.total_bytes - sample.memory.available_bytes
+                : 0ULL;
+        trends.memory.push(static_cast<double>(used) * 100.0 /
+                           static_cast<double>(sample.memory.total_bytes));
+    }
+    if (sample.loads.valid) {
+        // ロードはコア数で割って飽和度に正規化する。コア数不明なら1扱い。
+        const std::size_t cores = std::max<std::size_t>(sample.core_usages.size(), 1);
+        trends.load.push(sample.loads.one * 100.0 / static_cast<double>(cores));
+    }
+}
+
+// 1サンプル分を top 風レイアウトでフレームバッファへ組み立てる。
+// 送出は差分レンダラ側が担い、ここでは端末制御シーケンスを含めない。
+// バッファは呼び出し間で再利用されるため、定常状態ではヒープ確保が起きない。
+// 表示対象の上位選別を行うため sample は書き換える。
+// stats が与えられた場合は段別レイテンシの1行を追加する。
+// trends が与えられた場合は CPU/メモリ/ロードの各行末にスパークラインを足す。
+void render_sample(Sample &sample, FrameBuffer &frame, const StageStats *stats,
+                   const SparklineSet *trends, TopProcessSelector &top) {
+    frame.clear();
+
+    frame.append("top - ");
+    append_current_time(frame);
+    frame.append(" up ");
+    append_uptime(frame, sample.uptime);
+    frame.append(",  load average: ");
+    if (sample.loads.valid) {
+        frame.append_fixed(sample.loads.one, 2);
+        frame.append(", ");
+        frame.append_fixed(sample.loads.five, 2);
+        frame.append(", ");
+        frame.append_fixed(sample.loads.fifteen, 2);
+    } else {
+        frame.append("N/A, N/A, N/A");
     }
+    if (trends != nullptr) {
+        frame.append("  ");
+        trends->load.append_to(frame);
+    }
+    // バースト捕捉中はヘッダ行に明示する。戻れば自然に消える。
+    if (sample.burst) {
+        frame.append("  [burst]");
+    }
+    frame.append('\n');
 
-    const std::uint64_t days = seconds / 86400ULL;
-    seconds %= 86400ULL;
-    const std::uint64_t hours = seconds / 3600ULL;
-    seconds %= 3600ULL;
-    const std::uint64_t minutes = seconds / 60ULL;
+    // PSI はロード行の直下に avg10/avg60 を並べる。full 行を持つ
+    // リソースは some/full の両方を示す。取得不能な環境では行ごと省く。
+    if (sample.pressure.cpu.valid || sample.pressure.memory.valid ||
+        sample.pressure.io.valid) {
+        frame.append("Pressure : ");
+        const struct {
+            const char *label;
+            const PressureStatus &status;
+        } resources[] = {
+            {"cpu ", sample.pressure.cpu},
+            {", mem ", sample.pressure.memory},
+            {", io ", sample.pressure.io},
+        };
+        for (const auto &resource : resources) {
+            frame.append(resource.label);
+            if (!resource.status.valid) {
+                frame.append("N/A");
+                continue;
+            }
+            frame.append_fixed(resource.status.some_avg10, 2);
+            frame.append('/');
+            frame.append_fixed(resource.status.some_avg60, 2);
+            if (resource.status.has_full) {
+                frame.append(" full ");
+                frame.append_fixed(resource.status.full_avg10, 2);
+                frame.append('/');
+                frame.append_fixed(resource.status.full_avg60, 2);
+            }
+        }
+        frame.append('\n');
+    }
 
-    if (days > 0) {
-        oss << days << " day";
-        if (days > 1) {
-            oss << 's';
+    if (sample.tasks.valid) {
+        frame.append("Tasks: ");
+        frame.append_uint(sample.tasks.total);
+        frame.append(" total");
+        if (sample.tasks.has_states) {
+            frame.append(", ");
+            frame.append_uint(sample.tasks.running);
+            frame.append(" running, ");
+            frame.append_uint(sample.tasks.sleeping);
+            frame.append(" sleeping, ");
+            frame.append_uint(sample.tasks.stopped);
+            frame.append(" stopped, ");
+            frame.append_uint(sample.tasks.zombie);
+            frame.append(" zombie");
         }
-        oss << ", ";
+        frame.append('\n');
+    } else {
+        frame.append("Tasks: N/A\n");
     }
-    oss << std::setw(2) << std::setfill('0') << hours << ":"
-        << std::setw(2) << std::setfill('0') << minutes;
-    return oss.str();
-}
 
-// 現在時刻を HH:MM:SS フォーマットで返す。
-// Windows/Linux それぞれのスレッドセーフな localtime を利用する。
-std::string current_time_string() {
-    const auto now = std::chrono::system_clock::now();
-    const std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-#ifdef _WIN32
-    std::tm local_tm;
-    localtime_s(&local_tm, &now_c);
-#else
-    std::tm local_tm;
-    localtime_r(&now_c, &local_tm);
-#endif
-    std::ostringstream oss;
-    oss << std::put_time(&local_tm, "%H:%M:%S");
-    return oss.str();
-}
+    frame.append("%Cpu(s): ");
+    frame.append_fixed(sample.cpu_usage, 1);
+    frame.append(" us, ");
+    frame.append_fixed(100.0 - sample.cpu_usage, 1);
+    frame.append(" id");
+    if (trends != nullptr) {
+        frame.append("  ");
+        trends->cpu.append_to(frame);
+    }
+    frame.append('\n');
+
+    // GPU は %Cpu(s) 行の直下に1枚1行で並べる。NVML が無ければ省略。
+    if (sample.gpu.valid) {
+        for (std::uint32_t i = 0; i < sample.gpu.count; ++i) {
+            const GpuInfo &gpu = sample.gpu.gpus[i];
+            frame.append("%Gpu");
+            frame.append_uint_padded_left(i, 3);
+            frame.append(": ");
+            frame.append_uint_padded(gpu.utilization_percent, 3);
+            frame.append(" util, ");
+            append_memory_mib(frame, gpu.memory_used_bytes);
+            frame.append('/');
+            append_memory_mib(frame, gpu.memory_total_bytes);
+            frame.append(" MiB, ");
+            frame.append_fixed(static_cast<double>(gpu.power_milliwatts) / 1000.0, 1);
+            frame.append(" W\n");
+        }
+    }
+
+    // コアごとの使用率を4列ずつ並べる。前回スナップショットに無いコアは飛ばす。
+    for (std::size_t i = 0; i < sample.core_usages.size(); ++i) {
+        frame.append("%Cpu");
+        frame.append_uint_padded_left(i, 3);
+        frame.append(": ");
+        frame.append_fixed_padded(sample.core_usages[i], 1, 5);
+        frame.append(i % 4 == 3 ? "\n" : "  ");
+    }
+    if (sample.core_usages.size() % 4 != 0) {
+        frame.append('\n');
+    }
+
+    if (sample.memory.valid) {
+        const auto used = sample.memory.total_bytes > sample.memory.available_bytes
+                              ? sample.memory.total_bytes - sample.memory.available_bytes
+                              : 0ULL;
+        frame.append("MiB Mem : ");
+        append_memory_mib(frame, sample.memory.total_bytes);
+        frame.append(" total, ");
+        append_memory_mib(frame, used);
+        frame.append(" used, ");
+        append_memory_mib(frame, sample.memory.available_bytes);
+        frame.append(" free, ");
+        append_memory_mib(frame, sample.memory.buffers_bytes + sample.memory.cached_bytes);
+        frame.append(" buff/cache");
+        if (trends != nullptr) {
+            frame.append("  ");
+            trends->memory.append_to(frame);
+        }
+        frame.append('\n');
+        // NUMA ノード別の内訳。"MiB Mem :" の直下に1ノード1行で並べる。
+        // ヒュージページはバイトではなく枚数(free/total)で示す。
+        for (std::size_t i = 0; sample.numa.valid && i < sample.numa.count; ++i) {
+            const NumaNodeMemory &node = sample.numa.nodes[i];
+            frame.append("MiB Nd");
+            frame.append_uint(node.node_id);
+            frame.append(" : ");
+            append_memory_mib(frame, node.total_bytes);
+            frame.append(" total, ");
+            append_memory_mib(frame, node.total_bytes > node.free_bytes
+                                         ? node.total_bytes - node.free_bytes
+                                         : 0ULL);
+            frame.append(" used, ");
+            append_memory_mib(frame, node.free_bytes);
+            frame.append(" free");
+            if (node.hugepages_total > 0) {
+                frame.append(", huge ");
+                frame.append_uint(node.hugepages_free);
+                frame.append('/');
+                frame.append_uint(node.hugepages_total);
+            }
+            frame.append('\n');
+        }
+        if (sample.memory.swap_total_bytes > 0) {
+            const auto swap_used =
+                sample.memory.swap_total_bytes > sample.memory.swap_free_bytes
+                    ? sample.memory.swap_total_bytes - sample.memory.swap_free_bytes
+                    : 0ULL;
+            frame.append("MiB Swap: ");
+            append_memory_mib(frame, sample.memory.swap_total_bytes);
+            frame.append(" total, ");
+            append_memory_mib(frame, sample.memory.swap_free_bytes);
+            frame.append(" free, ");
+            append_memory_mib(frame, swap_used);
+            frame.append(" used\n");
+        }
+    } else {
+        frame.append("MiB Mem : N/A\n");
+    }
+
+    // cgroup はクォータ相対の消費を1行で示す。上限なしの値は素のまま出す。
+    if (sample.cgroup.valid) {
+        frame.append("Cgroup  : cpu ");
+        if (sample.cgroup.cpu_valid) {
+            frame.append_fixed(sample.cgroup.cores_used, 2);
+            if (sample.cgroup.quota_cores > 0.0) {
+                frame.append(" / ");
+                frame.append_fixed(sample.cgroup.quota_cores, 2);
+                frame.append(" cores (");
+                frame.append_fixed(sample.cgroup.cores_used * 100.0 /
+                                       sample.cgroup.quota_cores,
+                                   1);
+                frame.append("%)");
+            } else {
+                frame.append(" cores (no quota)");
+            }
+        } else {
+            frame.append("N/A");
+        }
+        frame.append(", mem ");
+        if (sample.cgroup.memory_valid) {
+            append_memory_mib(frame, sample.cgroup.memory_current_bytes);
+            if (sample.cgroup.memory_max_bytes > 0) {
+                frame.append(" / ");
+                append_memory_mib(frame, sample.cgroup.memory_max_bytes);
+            }
+            frame.append(" MiB");
+        } else {
+            frame.append("N/A");
+        }
+        frame.append('\n');
+    }
+
+    // ネットワーク/ディスクは 1s/10s/60s の順でレートを並べる。
+    // 60s 窓まで無通信のデバイスは行ごと省き、画面を占有させない。
+    if (sample.io.valid) {
+        for (std::uint32_t i = 0; i < sample.io.net_count; ++i) {
+            const NetDeviceRates &net = sample.io.net[i];
+            if (net.rx_bytes_per_sec[2] == 0.0 && net.tx_bytes_per_sec[2] == 0.0) {
+                continue;
+            }
+            frame.append("Net  ");
+            frame.append(net.name);
+            for (std::size_t pad = std::strlen(net.name); pad < 10; ++pad) {
+                frame.append(' ');
+            }
+            frame.append(" rx KiB/s ");
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_fixed(net.rx_bytes_per_sec[w] / 1024.0, 1);
+                frame.append(w + 1 < rate_window_count ? "/" : "  tx ");
+            }
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_fixed(net.tx_bytes_per_sec[w] / 1024.0, 1);
+                frame.append(w + 1 < rate_window_count ? "/" : "  pkt/s ");
+            }
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_uint(static_cast<std::uint64_t>(
+                    net.rx_packets_per_sec[w] + net.tx_packets_per_sec[w]));
+                frame.append(w + 1 < rate_window_count ? "/" : "\n");
+            }
+        }
+        for (std::uint32_t i = 0; i < sample.io.disk_count; ++i) {
+            const DiskDeviceRates &disk = sample.io.disks[i];
+            if (disk.read_bytes_per_sec[2] == 0.0 &&
+                disk.write_bytes_per_sec[2] == 0.0) {
+                continue;
+            }
+            frame.append("Disk ");
+            frame.append(disk.name);
+            for (std::size_t pad = std::strlen(disk.name); pad < 10; ++pad) {
+                frame.append(' ');
+            }
+            frame.append(" rd KiB/s ");
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_fixed(disk.read_bytes_per_sec[w] / 1024.0, 1);
+                frame.append(w + 1 < rate_window_count ? "/" : "  wr ");
+            }
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_fixed(disk.write_bytes_per_sec[w] / 1024.0, 1);
+                frame.append(w + 1 < rate_window_count ? "/" : "  IOPS ");
+            }
+            for (std::size_t w = 0; w < rate_window_count; ++w) {
+                frame.append_uint(static_cast<std::uint64_t>(
+                    disk.read_iops[w] + disk.write_iops[w]));
+                frame.append(w + 1 < rate_window_count ? "/" : "\n");
+            }
+        }
+    }
+
+    if (stats != nullptr) {
+        // 段ごとに p50/p99/max をマイクロ秒で1行に並べる。
+        frame.append("stats(us):");
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Stage::count); ++i) {
+            const Stage stage = static_cast<Stage>(i);
+            const LatencyHistogram &histogram = stats->of(stage);
+            frame.append(' ');
+            frame.append(stage_name(stage));
+            frame.append(' ');
+            frame.append_uint(histogram.percentile_ns(0.50) / 1000);
+            frame.append('/');
+            frame.append_uint(histogram.percentile_ns(0.99) / 1000);
+            frame.append('/');
+            frame.append_uint(histogram.max_ns() / 1000);
+        }
+        frame.append('\n');
+    }
 
-// バイト数を MiB 単位の少数表記へ変換する。
-// 表示整形専用のヘルパーで、1桁の小数精度を持たせる。
-std::string format_memory_mib(std::uint64_t bytes) {
-    const double mib = static_cast<double>(bytes) / (1024.0 * 1024.0);
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1) << mib;
-    return oss.str();
+    // %CPU上位のみ表示するため全体整列はせず、前周期のカットオフを
+    // ヒントにした上位選別に留める(コストは表示行数にほぼ比例する)。
+    if (!sample.processes.empty()) {
+        const std::size_t rows =
+            std::min<std::size_t>(sample.processes.size(), process_display_rows);
+        top.select(sample.processes, rows);
+        frame.append("\n    PID S  RES(MiB)  %CPU COMMAND\n");
+        for (std::size_t i = 0; i < rows; ++i) {
+            const ProcessInfo &proc = sample.processes[i];
+            frame.append_uint_padded(proc.pid, 7);
+            frame.append(' ');
+            frame.append(proc.state);
+            frame.append(' ');
+            frame.append_fixed_padded(
+                static_cast<double>(proc.rss_bytes) / (1024.0 * 1024.0), 1, 9);
+            frame.append(' ');
+            frame.append_fixed_padded(proc.cpu_percent, 1, 5);
+            frame.append(' ');
+            frame.append(proc.comm);
+            frame.append('\n');
+        }
+    }
 }
 } // namespace
 
-// 各種メトリクスを1秒周期で収集し、top風レイアウトで画面更新する。
+// 各種メトリクスを収集スレッドで集め、top風レイアウトで画面更新する。
+// --interval <ms> で最短10msまでの高頻度サンプリングを指定できる。
 // 取得に失敗した場合はエラーメッセージを表示して終了する。
-int main() {
+int main(int argc, char *argv[]) {
 #ifdef _WIN32
     enable_virtual_terminal_processing();
 #endif
 
-    CpuSnapshot previous_snapshot{};
-    if (!sample_cpu(previous_snapshot)) {
-        std::cerr << "Failed to read CPU statistics. Exiting.\n";
+    // サンプリング周期。描画はこれより遅い周期(最低1秒)で最新値のみを映す。
+    std::chrono::milliseconds interval{1000};
+    const char *record_path = nullptr;
+    const char *replay_path = nullptr;
+    // リング→アーカイブ圧縮の入出力。stride はダウンサンプル間隔。
+    const char *compact_source = nullptr;
+    const char *compact_destination = nullptr;
+    long compact_stride = 1;
+    // アーカイブ再生時の時間帯(ミリ秒エポック)。0/最大値は無制限。
+    std::uint64_t replay_since_ms = 0;
+    std::uint64_t replay_until_ms = ~0ULL;
+    const char *publish_destination = nullptr;
+    const char *cgroup_path = nullptr;
+    int listen_port = 0;
+    int aggregate_port = 0;
+    bool show_stats = false;
+    bool once = false;
+    OutputMode output_mode = OutputMode::screen;
+    // バースト捕捉のしきい値(複数指定可)と、最後の成立からの継続時間。
+    std::vector<TriggerCondition> triggers;
+    std::chrono::milliseconds burst_duration{5000};
+    // --once の2点目スナップショットまでの間隔。数十msで%CPUの分解能は
+    // 粗くなるが、スクリプト起動でCPU秒を浪費しないことを優先する。
+    std::chrono::milliseconds warmup{50};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--interval" && i + 1 < argc) {
+            const long value = std::strtol(argv[++i], nullptr, 10);
+            interval = std::chrono::milliseconds(std::max(10L, value));
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--compact" && i + 2 < argc) {
+            compact_source = argv[++i];
+            compact_destination = argv[++i];
+        } else if (arg == "--stride" && i + 1 < argc) {
+            compact_stride = std::max(1L, std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--since" && i + 1 < argc) {
+            replay_since_ms =
+                static_cast<std::uint64_t>(std::strtoll(argv[++i], nullptr, 10));
+        } else if (arg == "--until" && i + 1 < argc) {
+            replay_until_ms =
+                static_cast<std::uint64_t>(std::strtoll(argv[++i], nullptr, 10));
+        } else if (arg == "--listen" && i + 1 < argc) {
+            listen_port = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--publish" && i + 1 < argc) {
+            publish_destination = argv[++i];
+        } else if (arg == "--aggregate" && i + 1 < argc) {
+            aggregate_port = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--stats") {
+            show_stats = true;
+        } else if (arg == "--once") {
+            once = true;
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            const long value = std::strtol(argv[++i], nullptr, 10);
+            warmup = std::chrono::milliseconds(std::max(10L, value));
+        } else if (arg == "--cgroup" && i + 1 < argc) {
+            cgroup_path = argv[++i];
+        } else if (arg == "--trigger" && i + 1 < argc) {
+            TriggerCondition condition;
+            if (!parse_trigger(argv[++i], condition)) {
+                std::cerr << "Invalid trigger expression: " << argv[i] << "\n"
+                          << "Expected <metric><op><value>, e.g. cpu_usage>90"
+                             " or mem_available<2G (metrics: cpu_usage,"
+                             " mem_available, load1, tasks).\n";
+                return 1;
+            }
+            triggers.push_back(condition);
+        } else if (arg == "--burst" && i + 1 < argc) {
+            const long value = std::strtol(argv[++i], nullptr, 10);
+            burst_duration = std::chrono::milliseconds(std::max(100L, value));
+        } else if (arg == "--output" && i + 1 < argc) {
+            const std::string format = argv[++i];
+            if (format == "json") {
+                output_mode = OutputMode::json;
+            } else if (format == "csv") {
+                output_mode = OutputMode::csv;
+            } else {
+                std::cerr << "Unknown output format: " << format << "\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: benchmark_tool [--interval <ms>]"
+                         " [--once] [--warmup <ms>] [--output json|csv]"
+                         " [--cgroup <path>]"
+                         " [--trigger <expr>] [--burst <ms>]"
+                         " [--record <file>] [--replay <file>]"
+                         " [--compact <ring> <archive>] [--stride <n>]"
+                         " [--since <ms>] [--until <ms>] [--listen <port>]"
+                         " [--publish <addr:port>] [--aggregate <port>] [--stats]\n";
+            return 1;
+        }
+    }
+
+#ifndef _WIN32
+    // 圧縮モードはリングファイルを読み、stride ごとに間引いた
+    // レコードをアーカイブへ符号化して終了する。収集は行わない。
+    if (compact_source != nullptr) {
+        RingReplay source;
+        if (!source.open(compact_source)) {
+            std::cerr << "Failed to open ring file: " << compact_source << "\n";
+            return 1;
+        }
+        ArchiveWriter writer;
+        if (!writer.open(compact_destination)) {
+            std::cerr << "Failed to create archive: " << compact_destination
+                      << "\n";
+            return 1;
+        }
+        std::uint64_t written = 0;
+        for (std::uint64_t i = 0; i < source.size();
+             i += static_cast<std::uint64_t>(compact_stride)) {
+            writer.append(source.at(i));
+            ++written;
+        }
+        if (!writer.finish()) {
+            std::cerr << "Failed to finalize archive: " << compact_destination
+                      << "\n";
+            return 1;
+        }
+        std::cout << "Compacted " << written << " records into "
+                  << writer.block_count() << " blocks.\n";
+        return 0;
+    }
+    // アーカイブ再生。索引の二分探索で開始ブロックへ跳び、指定の
+    // 時間帯だけをブロック単位で復号して流す。
+    if (replay_path != nullptr) {
+        ArchiveReplay archive;
+        if (archive.open(replay_path)) {
+            FrameBuffer archive_frame;
+            DiffRenderer archive_renderer;
+            SparklineSet archive_trends;
+            TopProcessSelector archive_top;
+            std::vector<HistoryRecord> block_records;
+            for (std::uint64_t b = archive.find_block(replay_since_ms);
+                 b < archive.block_count() &&
+                 archive.block(b).first_timestamp_ms <= replay_until_ms;
+                 ++b) {
+                block_records.clear();
+                if (!archive.decode_block(b, block_records)) {
+                    std::cerr << "Corrupt archive block " << b << ".\n";
+                    return 1;
+                }
+                for (const HistoryRecord &record : block_records) {
+                    if (record.timestamp_ms < replay_since_ms ||
+                        record.timestamp_ms > replay_until_ms) {
+                        continue;
+                    }
+                    Sample sample = sample_from_record(record);
+                    push_trends(sample, archive_trends);
+                    render_sample(sample, archive_frame, nullptr,
+                                  &archive_trends, archive_top);
+                    archive_renderer.present(archive_frame);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+            return 0;
+        }
+    }
+    // 再生モードは記録ファイルを読み取り専用で mmap し、収集を行わず
+    // 古い順にフレームを流す。終端に達したら終了する。
+    if (replay_path != nullptr) {
+        RingReplay replay;
+        if (!replay.open(replay_path)) {
+            std::cerr << "Failed to open ring file: " << replay_path << "\n";
+            return 1;
+        }
+        FrameBuffer replay_frame;
+        DiffRenderer replay_renderer;
+        SparklineSet replay_trends;
+        TopProcessSelector replay_top;
+        for (std::uint64_t i = 0; i < replay.size(); ++i) {
+            Sample sample = sample_from_record(replay.at(i));
+            push_trends(sample, replay_trends);
+            render_sample(sample, replay_frame, nullptr, &replay_trends, replay_top);
+            replay_renderer.present(replay_frame);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return 0;
+    }
+    // 集約モードは自ホストの収集を行わず、受信したフリート状態だけを映す。
+    if (aggregate_port > 0) {
+        FleetAggregator aggregator;
+        if (!aggregator.open(static_cast<std::uint16_t>(aggregate_port))) {
+            std::cerr << "Failed to bind aggregate port " << aggregate_port << ".\n";
+            return 1;
+        }
+        FrameBuffer fleet_frame;
+        DiffRenderer fleet_renderer;
+        std::vector<const FleetHost *> sorted_hosts;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            const std::uint64_t now_ms = wall_clock_ms();
+            aggregator.drain(now_ms);
+            render_fleet(aggregator, now_ms, fleet_frame, sorted_hosts);
+            fleet_renderer.present(fleet_frame);
+        }
+    }
+#else
+    if (replay_path != nullptr) {
+        std::cerr << "--replay is only supported on Linux.\n";
         return 1;
     }
+    if (publish_destination != nullptr || aggregate_port > 0) {
+        std::cerr << "--publish/--aggregate are only supported on Linux.\n";
+        return 1;
+    }
+#endif
 
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    // サンプラはここで一度だけ構築し、保持すべき fd やバッファは以後
+    // 収集スレッドが使い回す。スレッド起動前の初回サンプルも同じ実体を使う。
+    static PlatformSampler sampler;
+    CpuSnapshot initial_snapshot{};
+    if (!sampler.sample_cpu(initial_snapshot)) {
+        std::cerr << "Failed to read CPU statistics. Exiting.\n";
+        return 1;
+    }
 
-        CpuSnapshot current_snapshot{};
-        if (!sample_cpu(current_snapshot)) {
+    // 1フレームだけ出して終わるスナップショットモード。2点目のCPU
+    // スナップショットを warmup 間隔で取り、収集スレッドや差分レンダラを
+    // 起こさずに素の stdout へ書いて抜ける。クリア画面エスケープも出さない。
+    if (once) {
+#ifndef _WIN32
+        // cgroup も warmup の前後で2点取り、同じ区間の差分を出す。
+        CgroupSampler once_cgroup;
+        const bool once_cgroup_ready = once_cgroup.init(cgroup_path);
+        if (once_cgroup_ready) {
+            once_cgroup.sample();
+        }
+#endif
+        std::this_thread::sleep_for(warmup);
+        CpuSnapshot second_snapshot{};
+        if (!sampler.sample_cpu(second_snapshot)) {
             std::cerr << "Failed to read CPU statistics. Exiting.\n";
             return 1;
         }
+        Sample sample{};
+        sample.cpu_usage = compute_cpu_usage(initial_snapshot, second_snapshot);
+        const std::size_t core_count = std::min(initial_snapshot.cores.size(),
+                                                second_snapshot.cores.size());
+        sample.core_usages.reserve(core_count);
+        for (std::size_t i = 0; i < core_count; ++i) {
+            sample.core_usages.push_back(compute_core_usage(
+                initial_snapshot.cores[i], second_snapshot.cores[i]));
+        }
+        sample.memory = sampler.sample_memory();
+        TickArena once_arena;
+        sampler.sample_tasks(
+            sample.tasks, sample.processes,
+            second_snapshot.total_ticks - initial_snapshot.total_ticks,
+            std::max<std::size_t>(core_count, 1), once_arena);
+        sample.loads = sampler.sample_load_averages();
+        sample.pressure = sampler.sample_pressure();
+        sample.uptime = sampler.uptime_seconds();
+#ifndef _WIN32
+        if (once_cgroup_ready) {
+            sample.cgroup = once_cgroup.sample();
+        }
+        NumaSampler once_numa;
+        if (once_numa.valid()) {
+            once_numa.sample(sample.numa);
+        }
+#endif
 
-        const double cpu_usage = compute_cpu_usage(previous_snapshot, current_snapshot);
-        previous_snapshot = current_snapshot;
+        FrameBuffer once_frame;
+        TopProcessSelector once_top;
+        render_sample(sample, once_frame, nullptr, nullptr, once_top);
+        once_frame.flush_to_stdout();
+        return 0;
+    }
 
-        const MemoryStatus memory = sample_memory();
-        const TaskSummary tasks = sample_tasks();
-        const LoadAverages loads = sample_load_averages();
-        const std::uint64_t uptime = uptime_seconds();
+#ifndef _WIN32
+    // メトリクス公開は収集とは独立したサーバスレッドで行う。
+    static MetricsServer metrics_server;
+    MetricsServer *metrics = nullptr;
+    if (listen_port > 0) {
+        if (!metrics_server.start(static_cast<std::uint16_t>(listen_port))) {
+            std::cerr << "Failed to listen on port " << listen_port << ".\n";
+            return 1;
+        }
+        metrics = &metrics_server;
+    }
+#else
+    void *metrics = nullptr;
+    if (listen_port > 0) {
+        std::cerr << "--listen is only supported on Linux.\n";
+        return 1;
+    }
+#endif
 
-        clear_screen();
+    static SampleRing ring;
+    static StageStats stage_stats;
+    FrameBuffer frame;
+    DiffRenderer renderer;
+    SparklineSet trends;
+    TopProcessSelector top_selector;
+    std::atomic<bool> collection_failed{false};
+    // 収集周期の共有値。キー操作('+'/'-')で実行中に書き換えられる。
+    static std::atomic<std::int64_t> interval_ms{0};
+    interval_ms.store(interval.count(), std::memory_order_relaxed);
+    std::thread collector(collection_loop, std::ref(interval_ms), std::ref(sampler),
+                          std::move(initial_snapshot), std::ref(ring),
+                          std::ref(collection_failed), std::ref(stage_stats),
+                          record_path, publish_destination, cgroup_path,
+                          triggers, burst_duration, metrics);
 
-        std::cout << "top - " << current_time_string()
-                  << " up " << format_uptime(uptime)
-                  << ",  load average: ";
-        if (loads.valid) {
-            std::cout << std::fixed << std::setprecision(2)
-                      << loads.one << ", " << loads.five << ", " << loads.fifteen;
-        } else {
-            std::cout << "N/A, N/A, N/A";
+    // ストリーム出力モード。周期ごとに溜まったサンプルを全て1行ずつ
+    // シリアライズし、32KiB 到達か1秒経過のどちらか早い方で1回の write に
+    // まとめて流す。10Hz でも syscall はフラッシュごとの1回で済む。
+    if (output_mode != OutputMode::screen) {
+        constexpr std::size_t flush_threshold = 32 * 1024;
+        constexpr std::chrono::seconds flush_interval{1};
+        FrameBuffer out;
+        if (output_mode == OutputMode::csv) {
+            append_csv_header(out);
+        }
+        auto last_flush = std::chrono::steady_clock::now();
+        while (true) {
+            std::this_thread::sleep_for(interval);
+            if (collection_failed.load(std::memory_order_acquire)) {
+                out.flush_to_stdout();
+                std::cerr << "Failed to read CPU statistics. Exiting.\n";
+                collector.join();
+                return 1;
+            }
+            Sample sample{};
+            while (ring.pop(sample)) {
+                if (output_mode == OutputMode::json) {
+                    append_sample_json(sample, out);
+                } else {
+                    append_sample_csv(sample, out);
+                }
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (out.size() >= flush_threshold || now - last_flush >= flush_interval) {
+                out.flush_to_stdout();
+                out.clear();
+                last_flush = now;
+            }
         }
-        std::cout << "\n";
+    }
 
-        if (tasks.valid) {
-            std::cout << "Tasks: " << tasks.total << " total"
-                      << ", 1 running, 0 sleeping, 0 stopped, 0 zombie\n";
-        } else {
-            std::cout << "Tasks: N/A\n";
-        }
-
-        std::cout << std::fixed << std::setprecision(1)
-                  << "%Cpu(s): " << cpu_usage
-                  << " us, " << (100.0 - cpu_usage)
-                  << " id\n";
-
-        if (memory.valid) {
-            const auto used = memory.total_bytes > memory.available_bytes
-                                  ? memory.total_bytes - memory.available_bytes
-                                  : 0ULL;
-            std::cout << "MiB Mem : " << format_memory_mib(memory.total_bytes)
-                      << " total, " << format_memory_mib(used)
-                      << " used, " << format_memory_mib(memory.available_bytes)
-                      << " free\n";
-        } else {
-            std::cout << "MiB Mem : N/A\n";
+    // 描画ループ。次の描画時刻までの待ちをキー入力の poll に流用する
+    // ため、キーへ即応しても収集周期へは影響しない。'q' 終了、
+    // スペース/'p' で描画一時停止(収集と記録は続く)、'm'/'c' で
+    // 整列キー、'+'/'-' で周期の半減/倍化を行う。
+    KeyboardInput keyboard;
+    // 端末が停滞しても描画スレッドが write(2) で眠り込まないよう、
+    // stdout は非ブロッキングにする。詰まっている間のフレームは合体
+    // され、復帰時に全画面を描き直す。収集・記録側は影響を受けない。
+    NonblockingStdout terminal_out;
+    terminal_out.enable();
+    bool display_stalled = false;
+    const auto render_floor = std::chrono::milliseconds(1000);
+    bool paused = false;
+    auto next_render = std::chrono::steady_clock::now() +
+                       std::max(interval, render_floor);
+    while (true) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now < next_render) {
+            const int key = keyboard.wait_key(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_render - now) +
+                std::chrono::milliseconds(1));
+            switch (key) {
+            case 'q':
+                // 収集スレッドは無限ループなので、プロセス終了に任せて
+                // 切り離す(記録は mmap 経由で毎追記ごとに永続化済み)。
+                collector.detach();
+                return 0;
+            case ' ':
+            case 'p':
+                paused = !paused;
+                break;
+            case 'm':
+                top_selector.set_sort_key(ProcessSortKey::memory);
+                break;
+            case 'c':
+                top_selector.set_sort_key(ProcessSortKey::cpu);
+                break;
+            case '+': {
+                const std::int64_t current =
+                    interval_ms.load(std::memory_order_relaxed);
+                interval_ms.store(std::max<std::int64_t>(10, current / 2),
+                                  std::memory_order_relaxed);
+                break;
+            }
+            case '-': {
+                const std::int64_t current =
+                    interval_ms.load(std::memory_order_relaxed);
+                interval_ms.store(std::min<std::int64_t>(10000, current * 2),
+                                  std::memory_order_relaxed);
+                break;
+            }
+            default:
+                break;
+            }
+            continue;
+        }
+        next_render =
+            now + std::max(std::chrono::milliseconds(
+                               interval_ms.load(std::memory_order_relaxed)),
+                           render_floor);
+        if (collection_failed.load(std::memory_order_acquire)) {
+            std::cerr << "Failed to read CPU statistics. Exiting.\n";
+            collector.join();
+            return 1;
         }
 
-        std::cout.flush();
+        // 溜まったサンプルを全て吸い出し、最新の1件だけを描画する。
+        // 一時停止中も吸い出しは続け、描画コストだけをゼロにする。
+        Sample sample{};
+        bool have_sample = false;
+        while (ring.pop(sample)) {
+            have_sample = true;
+        }
+        if (have_sample && !paused) {
+            StageTimer timer(stage_stats, Stage::render);
+            if (!terminal_out.drain()) {
+                // 端末が詰まっている。中間フレームは送らず最新状態の
+                // 描画だけを次の機会へ持ち越す(フレーム合体)。
+                display_stalled = true;
+                continue;
+            }
+            if (display_stalled) {
+                // 停滞中に画面が最新とずれたので全画面から描き直す。
+                renderer.invalidate();
+                display_stalled = false;
+            }
+            push_trends(sample, trends);
+            render_sample(sample, frame, show_stats ? &stage_stats : nullptr,
+                          &trends, top_selector);
+            renderer.present(frame, terminal_out);
+        }
     }
 
     return 0;
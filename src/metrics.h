@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// プラットフォーム別サンプラが共通で埋める計測データの定義。
+// 収集(サンプラ)・描画・記録のどの層からも参照されるため、
+// OS 依存の型や API はここには置かない。
+
+// コア1つ分の累積チック値。CpuSnapshot::cores の要素として保持する。
+struct CoreTicks {
+    std::uint64_t idle_ticks{};
+    std::uint64_t total_ticks{};
+};
+
+struct CpuSnapshot {
+    std::uint64_t idle_ticks{};
+    std::uint64_t total_ticks{};
+    // cpuN 行ごとの値。Windows など取得できない環境では空のままとする。
+    std::vector<CoreTicks> cores;
+};
+
+struct MemoryStatus {
+    std::uint64_t total_bytes{};
+    std::uint64_t available_bytes{};
+    // 以下はダッシュボード向けの追加フィールド。Linux でのみ埋まる。
+    std::uint64_t buffers_bytes{};
+    std::uint64_t cached_bytes{};
+    std::uint64_t dirty_bytes{};
+    std::uint64_t slab_bytes{};
+    std::uint64_t swap_total_bytes{};
+    std::uint64_t swap_free_bytes{};
+    bool valid{false};
+};
+
+struct TaskSummary {
+    std::size_t total{};
+    std::size_t running{};
+    std::size_t sleeping{};
+    std::size_t stopped{};
+    std::size_t zombie{};
+    // 状態別の内訳まで取得できた場合のみ true。Windows では総数のみとなる。
+    bool has_states{false};
+    bool valid{false};
+};
+
+struct LoadAverages {
+    double one{};
+    double five{};
+    double fifteen{};
+    bool valid{false};
+};
+
+// /proc/pressure/* 1リソース分の PSI 値。full 行が無いリソース
+// (カーネルによっては cpu)では has_full が false のままになる。
+struct PressureStatus {
+    double some_avg10{};
+    double some_avg60{};
+    double full_avg10{};
+    double full_avg60{};
+    bool has_full{false};
+    bool valid{false};
+};
+
+// cpu/memory/io の PSI をまとめたもの。Linux でのみ埋まる。
+struct PressureSet {
+    PressureStatus cpu;
+    PressureStatus memory;
+    PressureStatus io;
+};
+
+// プロセス1件分の表示用情報。comm はヌル終端で保持し、
+// %CPU はスキャン後の差分計算で埋める。
+struct ProcessInfo {
+    std::int32_t pid{};
+    char state{'?'};
+    std::uint64_t rss_bytes{};
+    std::uint64_t cpu_ticks{};
+    double cpu_percent{};
+    char comm[17]{};
+};
+
+// Tasks 行に出す状態別の集計。スキャンと同時に数え上げる。
+struct ProcessStateCounts {
+    std::size_t total{};
+    std::size_t running{};
+    std::size_t sleeping{};
+    std::size_t stopped{};
+    std::size_t zombie{};
+};
+
+// 直近2回のCPUスナップショットの差分から使用率を算出する。
+// 分母がゼロの場合は0%として扱い例外的なスパイクを避ける。
+inline double compute_cpu_usage(const CpuSnapshot &prev, const CpuSnapshot &curr) {
+    const std::uint64_t idle_delta = curr.idle_ticks - prev.idle_ticks;
+    const std::uint64_t total_delta = curr.total_ticks - prev.total_ticks;
+    if (total_delta == 0) {
+        return 0.0;
+    }
+    const std::uint64_t active_delta = total_delta - idle_delta;
+    return static_cast<double>(active_delta) * 100.0 / static_cast<double>(total_delta);
+}
+
+// コア単体のチック差分から使用率を算出する。集計版と同じ丸め規則を使う。
+// ホットプラグ等で前回値が欠けるコアは呼び出し側で除外する前提。
+inline double compute_core_usage(const CoreTicks &prev, const CoreTicks &curr) {
+    const std::uint64_t idle_delta = curr.idle_ticks - prev.idle_ticks;
+    const std::uint64_t total_delta = curr.total_ticks - prev.total_ticks;
+    if (total_delta == 0) {
+        return 0.0;
+    }
+    const std::uint64_t active_delta = total_delta - idle_delta;
+    return static_cast<double>(active_delta) * 100.0 / static_cast<double>(total_delta);
+}
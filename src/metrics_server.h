@@ -0,0 +1,168 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 収集済みメトリクスを Prometheus テキスト形式で公開する小型HTTPサーバ。
+// epoll ベースの非ブロッキング1スレッドで動き、応答本文は収集スレッドが
+// アトミックに差し替える整形済みスナップショットをそのまま返すだけなので、
+// スクレイプが収集周期へ影響することはない。
+class MetricsServer {
+public:
+    MetricsServer() : snapshot_(std::make_shared<const std::string>()) {}
+
+    ~MetricsServer() {
+        stop();
+    }
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    // 指定ポートで待ち受けを開始し、サーバスレッドを起動する。
+    bool start(std::uint16_t port) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            return false;
+        }
+        const int enable = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)) != 0 ||
+            ::listen(listen_fd_, 128) != 0) {
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listen_fd_;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread(&MetricsServer::serve_loop, this);
+        return true;
+    }
+
+    bool running() const {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    // 整形済みの本文を差し替える。収集スレッドから毎周期呼ばれる。
+    // 配信中の旧スナップショットは shared_ptr が生かしたまま保つ。
+    void publish(std::string body) {
+        std::atomic_store_explicit(
+            &snapshot_, std::shared_ptr<const std::string>(
+                            std::make_shared<const std::string>(std::move(body))),
+            std::memory_order_release);
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+            epoll_fd_ = -1;
+        }
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+        }
+    }
+
+private:
+    // epoll ループ本体。accept したクライアントの最初の読み取り契機で
+    // 現行スナップショットを書いて閉じる、1往復だけの素朴なHTTPを話す。
+    void serve_loop() {
+        epoll_event events[64];
+        while (running_.load(std::memory_order_acquire)) {
+            const int ready = ::epoll_wait(epoll_fd_, events, 64, 200);
+            for (int i = 0; i < ready; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == listen_fd_) {
+                    accept_clients();
+                } else {
+                    respond_and_close(fd);
+                }
+            }
+        }
+    }
+
+    void accept_clients() {
+        while (true) {
+            const int client = ::accept4(listen_fd_, nullptr, nullptr,
+                                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client < 0) {
+                return;
+            }
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = client;
+            if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client, &event) != 0) {
+                ::close(client);
+            }
+        }
+    }
+
+    // リクエスト行は読み捨て、スナップショットを1回の応答で返して閉じる。
+    void respond_and_close(int fd) {
+        char request[2048];
+        const ssize_t n = ::recv(fd, request, sizeof(request), 0);
+        if (n <= 0) {
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            return;
+        }
+
+        const std::shared_ptr<const std::string> body = std::atomic_load_explicit(
+            &snapshot_, std::memory_order_acquire);
+
+        char header[160];
+        const int header_length = std::snprintf(
+            header, sizeof(header),
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n\r\n",
+            body->size());
+        ::send(fd, header, static_cast<std::size_t>(header_length), MSG_NOSIGNAL);
+        ::send(fd, body->data(), body->size(), MSG_NOSIGNAL);
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+    }
+
+    std::shared_ptr<const std::string> snapshot_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int listen_fd_{-1};
+    int epoll_fd_{-1};
+};
+
+#endif // !_WIN32
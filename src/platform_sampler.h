@@ -0,0 +1,12 @@
+#pragma once
+
+// OS 別サンプラのコンパイル時選択。収集ループや main は
+// PlatformSampler だけを相手にし、個別の #ifdef 分岐を持たない。
+// 仮想関数を介さない静的ディスパッチなのでインライン化も効く。
+#ifdef _WIN32
+#include "sampler_windows.h"
+using PlatformSampler = WindowsSampler;
+#else
+#include "sampler_linux.h"
+using PlatformSampler = LinuxSampler;
+#endif
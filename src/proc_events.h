@@ -0,0 +1,144 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// netlink proc コネクタで fork/exit イベントを購読し、プロセス総数を
+// 増減イベントだけで追従させるリスナ。総数は周期ごとに±1程度しか
+// 動かないため、全走査を間引いた周期の Tasks 行をこの推定値で補正
+// すれば、最も高価なコレクタが O(変化数) のイベント処理になる。
+// 購読には CAP_NET_ADMIN が要るため、失敗時は invalid のまま従来の
+// 走査値を使い続ける。
+class ProcEventListener {
+public:
+    ProcEventListener() = default;
+
+    ~ProcEventListener() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    ProcEventListener(const ProcEventListener &) = delete;
+    ProcEventListener &operator=(const ProcEventListener &) = delete;
+
+    // コネクタへ接続して PROC_CN_MCAST_LISTEN を送る。権限不足や
+    // カーネル非対応(CONFIG_PROC_EVENTS 無効)では false。
+    bool init() {
+        fd_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                       NETLINK_CONNECTOR);
+        if (fd_ < 0) {
+            return false;
+        }
+        sockaddr_nl address{};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = CN_IDX_PROC;
+        if (::bind(fd_, reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)) != 0) {
+            close_fd();
+            return false;
+        }
+
+        char request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(enum proc_cn_mcast_op))];
+        std::memset(request, 0, sizeof(request));
+        auto *header = reinterpret_cast<nlmsghdr *>(request);
+        header->nlmsg_len =
+            NLMSG_LENGTH(sizeof(cn_msg) + sizeof(enum proc_cn_mcast_op));
+        header->nlmsg_type = NLMSG_DONE;
+        auto *connector = static_cast<cn_msg *>(NLMSG_DATA(header));
+        connector->id.idx = CN_IDX_PROC;
+        connector->id.val = CN_VAL_PROC;
+        connector->len = sizeof(enum proc_cn_mcast_op);
+        *reinterpret_cast<enum proc_cn_mcast_op *>(connector->data) =
+            PROC_CN_MCAST_LISTEN;
+        if (::send(fd_, request, header->nlmsg_len, 0) !=
+            static_cast<ssize_t>(header->nlmsg_len)) {
+            close_fd();
+            return false;
+        }
+        return true;
+    }
+
+    bool valid() const {
+        return fd_ >= 0;
+    }
+
+    // 全走査の結果で推定値を合わせ直す。イベントの取りこぼし(ソケット
+    // バッファ溢れ等)はここで自然に修正される。
+    void reconcile(std::size_t total) {
+        total_ = static_cast<std::int64_t>(total);
+    }
+
+    // 溜まったイベントを非ブロッキングで消化し総数へ適用する。
+    // スレッドの clone は tgid≠pid で届くため数えない(/proc 直下の
+    // 走査と同じ「プロセス数」を維持する)。
+    void drain() {
+        if (fd_ < 0) {
+            return;
+        }
+        char buffer[4096];
+        while (true) {
+            const ssize_t received = ::recv(fd_, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                return;
+            }
+            int remaining = static_cast<int>(received);
+            for (const nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer);
+                 NLMSG_OK(header, remaining);
+                 header = NLMSG_NEXT(header, remaining)) {
+                if (header->nlmsg_type != NLMSG_DONE) {
+                    continue;
+                }
+                const auto *connector =
+                    static_cast<const cn_msg *>(NLMSG_DATA(header));
+                if (connector->id.idx != CN_IDX_PROC ||
+                    connector->id.val != CN_VAL_PROC) {
+                    continue;
+                }
+                const auto *event =
+                    reinterpret_cast<const proc_event *>(connector->data);
+                switch (event->what) {
+                case proc_event::PROC_EVENT_FORK:
+                    if (event->event_data.fork.child_pid ==
+                        event->event_data.fork.child_tgid) {
+                        ++total_;
+                    }
+                    break;
+                case proc_event::PROC_EVENT_EXIT:
+                    if (event->event_data.exit.process_pid ==
+                            event->event_data.exit.process_tgid &&
+                        total_ > 0) {
+                        --total_;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    std::size_t estimated_total() const {
+        return total_ > 0 ? static_cast<std::size_t>(total_) : 0;
+    }
+
+private:
+    void close_fd() {
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    int fd_{-1};
+    std::int64_t total_{0};
+};
+
+#endif // !_WIN32
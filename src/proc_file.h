@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// 起動時に開いた fd を保持し、毎周期 pread(fd, buf, size, 0) で先頭から
+// 読み直す /proc 系ファイル。周期ごとの open/close と iostream 構築を
+// ホットパスから排除するためのサンプラ基盤。
+class ProcFile {
+public:
+    // パスが実行時にしか決まらない場合(cgroup 等)は既定構築して
+    // 後から open() する。
+    ProcFile() = default;
+
+    explicit ProcFile(const char *path, std::size_t initial_capacity = 8 * 1024)
+        : buffer_(initial_capacity) {
+        fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    // 指定パスを開き直す。以後は構築時に開いた場合と同じに扱える。
+    bool open(const char *path, std::size_t initial_capacity = 8 * 1024) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        if (buffer_.size() < initial_capacity) {
+            buffer_.resize(initial_capacity);
+        }
+        fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+        return fd_ >= 0;
+    }
+
+    ~ProcFile() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    ProcFile(const ProcFile &) = delete;
+    ProcFile &operator=(const ProcFile &) = delete;
+
+    bool valid() const {
+        return fd_ >= 0;
+    }
+
+    // ファイル全体を内部バッファへ読み込み、バイト数を返す(失敗時は負)。
+    // バッファ不足時は拡張して読み直すため、定常状態では read は1回で済む。
+    // io_uring 側で先読み済みの場合はその長さを消費して即座に返す。
+    ssize_t read_all() {
+        if (preloaded_length_ >= 0) {
+            const ssize_t n = preloaded_length_;
+            preloaded_length_ = -1;
+            return n;
+        }
+        if (fd_ < 0) {
+            return -1;
+        }
+        while (true) {
+            const ssize_t n = ::pread(fd_, buffer_.data(), buffer_.size(), 0);
+            if (n < 0) {
+                return -1;
+            }
+            if (static_cast<std::size_t>(n) < buffer_.size()) {
+                return n;
+            }
+            buffer_.resize(buffer_.size() * 2);
+        }
+    }
+
+    const char *data() const {
+        return buffer_.data();
+    }
+
+    // 以下はバッチ読み取り(io_uring)が直接バッファへ書くための口。
+    int fd() const {
+        return fd_;
+    }
+
+    char *writable_data() {
+        return buffer_.data();
+    }
+
+    std::size_t capacity() const {
+        return buffer_.size();
+    }
+
+    // 外部で読み込んだ長さを登録する。次の read_all が1回だけ消費する。
+    void set_preloaded(ssize_t length) {
+        preloaded_length_ = length;
+    }
+
+private:
+    int fd_{-1};
+    ssize_t preloaded_length_{-1};
+    std::vector<char> buffer_;
+};
+
+#endif // !_WIN32
@@ -0,0 +1,644 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "metrics.h"
+#include "uring_reader.h"
+
+// PID → 前回チック値のフラットな開番地法ハッシュ表。
+// 世代番号で退出済みPIDを遅延失効させ、定常状態では再確保を行わない。
+class PidTickMap {
+public:
+    PidTickMap() : slots_(initial_capacity) {}
+
+    // 新しいスキャン世代を開始する。前世代の値だけが差分の対象になる。
+    void begin_generation() {
+        ++generation_;
+    }
+
+    // pid の前回チック値を取り出しつつ今回値で置き換える。
+    // 前世代に記録が無い(新規プロセス等)場合は false を返す。
+    bool exchange(std::int32_t pid, std::uint64_t ticks, std::uint64_t &previous) {
+        if (occupied_ * 2 >= slots_.size()) {
+            grow();
+        }
+        const std::size_t mask = slots_.size() - 1;
+        std::size_t index = hash_pid(pid) & mask;
+        while (true) {
+            Slot &slot = slots_[index];
+            if (slot.pid == pid) {
+                const bool live = slot.generation + 1 == generation_;
+                previous = slot.ticks;
+                slot.ticks = ticks;
+                slot.generation = generation_;
+                return live;
+            }
+            if (slot.pid == 0) {
+                slot.pid = pid;
+                slot.ticks = ticks;
+                slot.generation = generation_;
+                ++occupied_;
+                return false;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+private:
+    struct Slot {
+        std::int32_t pid{};
+        std::uint32_t generation{};
+        std::uint64_t ticks{};
+    };
+
+    static constexpr std::size_t initial_capacity = 8192;
+
+    static std::size_t hash_pid(std::int32_t pid) {
+        return static_cast<std::uint32_t>(pid) * 2654435761u;
+    }
+
+    // 現世代と前世代のエントリだけを新しい表へ移し替える。
+    // 退出済みPIDはここで捨てられるため、表は実プロセス数に追随する。
+    void grow() {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(old.size() * 2, Slot{});
+        occupied_ = 0;
+        const std::size_t mask = slots_.size() - 1;
+        for (const Slot &slot : old) {
+            if (slot.pid == 0 || slot.generation + 1 < generation_) {
+                continue;
+            }
+            std::size_t index = hash_pid(slot.pid) & mask;
+            while (slots_[index].pid != 0) {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = slot;
+            ++occupied_;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t occupied_{0};
+    std::uint32_t generation_{0};
+};
+
+// "[pid]/stat" 形式の相対パスを組み立てる。snprintf を避けた手書き整形。
+inline void build_proc_stat_path(std::int32_t pid, char *path) {
+    char *p = path;
+    char digits[12];
+    int digit_count = 0;
+    while (pid > 0) {
+        digits[digit_count++] = static_cast<char>('0' + pid % 10);
+        pid /= 10;
+    }
+    while (digit_count > 0) {
+        *p++ = digits[--digit_count];
+    }
+    std::memcpy(p, "/stat", 6);
+}
+
+// stat 1行ぶんのテキストから必要フィールドを抜き出す。
+// comm は括弧を含み得るため、最後の ')' から後ろを解析する。
+inline bool parse_proc_stat(const char *text, ssize_t length, std::int32_t pid,
+                            std::uint64_t page_size, ProcessInfo &info) {
+    const char *open_paren = static_cast<const char *>(
+        std::memchr(text, '(', static_cast<std::size_t>(length)));
+    const char *close_paren = nullptr;
+    for (const char *q = text + length - 1; q > text; --q) {
+        if (*q == ')') {
+            close_paren = q;
+            break;
+        }
+    }
+    if (open_paren == nullptr || close_paren == nullptr || close_paren < open_paren) {
+        return false;
+    }
+
+    info.pid = pid;
+    const std::size_t comm_length =
+        std::min(static_cast<std::size_t>(close_paren - open_paren - 1),
+                 sizeof(info.comm) - 1);
+    std::memcpy(info.comm, open_paren + 1, comm_length);
+    info.comm[comm_length] = '\0';
+
+    // ')' の後ろは「state ppid pgrp ...」の空白区切り。utime/stime は
+    // state から数えて10,11番目、rss は20番目の数値フィールドにあたる。
+    const char *cursor = close_paren + 1;
+    while (*cursor == ' ') {
+        ++cursor;
+    }
+    info.state = *cursor;
+    ++cursor;
+
+    std::uint64_t utime = 0;
+    std::uint64_t stime = 0;
+    std::uint64_t rss_pages = 0;
+    int field = 0;
+    while (*cursor != '\0' && field < 21) {
+        while (*cursor == ' ') {
+            ++cursor;
+        }
+        std::uint64_t number = 0;
+        const bool negative = (*cursor == '-');
+        if (negative) {
+            ++cursor;
+        }
+        while (*cursor >= '0' && *cursor <= '9') {
+            number = number * 10 + static_cast<std::uint64_t>(*cursor - '0');
+            ++cursor;
+        }
+        if (field == 10) {
+            utime = number;
+        } else if (field == 11) {
+            stime = number;
+        } else if (field == 20) {
+            rss_pages = negative ? 0 : number;
+        }
+        ++field;
+    }
+
+    info.cpu_ticks = utime + stime;
+    info.rss_bytes = rss_pages * page_size;
+    return true;
+}
+
+// /proc/[pid]/stat の読み取り+解析をシャード分割で並列化する常駐
+// ワーカープール。PID単価は不均一(カーネルスレッドは軽く、巨大
+// プロセスは重い)ため、自分のシャードを使い切ったワーカーは残量
+// 最大のシャードから後ろ半分を奪う。シャードは 64bit に cursor/end を
+// 詰めた単一ワードで表し、請求も横取りも CAS 1回で済む。
+class ScanWorkerPool {
+public:
+    ScanWorkerPool() = default;
+
+    ~ScanWorkerPool() {
+        if (workers_.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ScanWorkerPool(const ScanWorkerPool &) = delete;
+    ScanWorkerPool &operator=(const ScanWorkerPool &) = delete;
+
+    // ワーカーを起動する。大規模ホスト以外で常駐させても無駄なので、
+    // 呼び出し側が初めて閾値を超えたときに一度だけ呼ぶ。
+    void start(int proc_fd, std::uint64_t page_size) {
+        if (!workers_.empty()) {
+            return;
+        }
+        proc_fd_ = proc_fd;
+        page_size_ = page_size;
+        const std::size_t hardware = std::thread::hardware_concurrency();
+        const std::size_t count =
+            std::min<std::size_t>(8, std::max<std::size_t>(2, hardware / 4));
+        shards_ = std::vector<Shard>(count);
+        workers_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_.emplace_back(&ScanWorkerPool::worker_loop, this, i);
+        }
+    }
+
+    bool running() const {
+        return !workers_.empty();
+    }
+
+    // PIDリストを等分シャードとして配り、全ワーカーの完了を待って
+    // 結果を連結する。ワーカーごとの結果バッファは容量を保持したまま
+    // 使い回すので、定常状態の確保はゼロ。
+    void scan(const std::int32_t *pids, std::size_t count,
+              std::vector<ProcessInfo> &processes) {
+        const std::size_t worker_count = workers_.size();
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < worker_count; ++i) {
+            const std::size_t end = count * (i + 1) / worker_count;
+            shards_[i].range.store(pack_range(begin, end),
+                                   std::memory_order_relaxed);
+            begin = end;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pids_ = pids;
+            pending_ = worker_count;
+            ++job_generation_;
+        }
+        wake_.notify_all();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return pending_ == 0; });
+        }
+        for (Shard &shard : shards_) {
+            processes.insert(processes.end(), shard.results.begin(),
+                             shard.results.end());
+        }
+    }
+
+private:
+    // cursor(下位32bit)と end(上位32bit)を1ワードに詰めたシャード。
+    // results は scan をまたいで容量を保持する。
+    struct Shard {
+        std::atomic<std::uint64_t> range{0};
+        std::vector<ProcessInfo> results;
+    };
+
+    static std::uint64_t pack_range(std::size_t cursor, std::size_t end) {
+        return (static_cast<std::uint64_t>(end) << 32) |
+               static_cast<std::uint64_t>(cursor);
+    }
+
+    // まず自分のシャードから1件請求し、空なら残量最大のシャードの
+    // 後ろ半分を自分のシャードへ移して続ける。残量1のシャードは
+    // 持ち主に任せる(奪っても勝ち分が無い)。
+    bool claim(std::size_t self_index, std::size_t &pid_index) {
+        Shard &self = shards_[self_index];
+        while (true) {
+            std::uint64_t packed = self.range.load(std::memory_order_relaxed);
+            const std::uint32_t cursor = static_cast<std::uint32_t>(packed);
+            const std::uint32_t end = static_cast<std::uint32_t>(packed >> 32);
+            if (cursor < end) {
+                if (self.range.compare_exchange_weak(packed, packed + 1,
+                                                     std::memory_order_relaxed)) {
+                    pid_index = cursor;
+                    return true;
+                }
+                continue;
+            }
+            if (!steal_into(self_index)) {
+                return false;
+            }
+        }
+    }
+
+    bool steal_into(std::size_t self_index) {
+        while (true) {
+            std::size_t victim = shards_.size();
+            std::uint32_t best_remaining = 1;
+            std::uint64_t victim_packed = 0;
+            for (std::size_t i = 0; i < shards_.size(); ++i) {
+                if (i == self_index) {
+                    continue;
+                }
+                const std::uint64_t packed =
+                    shards_[i].range.load(std::memory_order_relaxed);
+                const std::uint32_t cursor = static_cast<std::uint32_t>(packed);
+                const std::uint32_t end = static_cast<std::uint32_t>(packed >> 32);
+                const std::uint32_t remaining = end > cursor ? end - cursor : 0;
+                if (remaining > best_remaining) {
+                    best_remaining = remaining;
+                    victim = i;
+                    victim_packed = packed;
+                }
+            }
+            if (victim == shards_.size()) {
+                return false;
+            }
+            const std::uint32_t cursor = static_cast<std::uint32_t>(victim_packed);
+            const std::uint32_t end = static_cast<std::uint32_t>(victim_packed >> 32);
+            const std::uint32_t mid = cursor + (end - cursor + 1) / 2;
+            // 持ち主には前半 [cursor, mid) を残し、後半 [mid, end) を奪う。
+            if (shards_[victim].range.compare_exchange_weak(
+                    victim_packed, pack_range(cursor, mid),
+                    std::memory_order_relaxed)) {
+                shards_[self_index].range.store(pack_range(mid, end),
+                                                std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    void worker_loop(std::size_t index) {
+        std::uint64_t seen_generation = 0;
+        char path[32];
+        char buffer[4096];
+        while (true) {
+            const std::int32_t *pids = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] {
+                    return stop_ || job_generation_ != seen_generation;
+                });
+                if (stop_) {
+                    return;
+                }
+                seen_generation = job_generation_;
+                pids = pids_;
+            }
+
+            Shard &self = shards_[index];
+            self.results.clear();
+            std::size_t pid_index = 0;
+            while (claim(index, pid_index)) {
+                const std::int32_t pid = pids[pid_index];
+                build_proc_stat_path(pid, path);
+                const int fd = ::openat(proc_fd_, path, O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    continue;
+                }
+                const ssize_t length = ::read(fd, buffer, sizeof(buffer) - 1);
+                ::close(fd);
+                if (length <= 0) {
+                    continue;
+                }
+                ProcessInfo info{};
+                if (parse_proc_stat(buffer, length, pid, page_size_, info)) {
+                    self.results.push_back(info);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0) {
+                    done_.notify_one();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::vector<Shard> shards_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::int32_t *pids_{nullptr};
+    std::size_t pending_{0};
+    std::uint64_t job_generation_{0};
+    bool stop_{false};
+    int proc_fd_{-1};
+    std::uint64_t page_size_{4096};
+};
+
+// getdents64 で /proc を直接走査し、各 /proc/[pid]/stat を openat +
+// 1回の read で読み取るプロセススキャナ。directory_iterator 経由の
+// パス文字列生成を排し、5,000プロセス級のホストでも数msで回ることを狙う。
+class ProcessScanner {
+public:
+    ProcessScanner() {
+        proc_fd_ = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        dents_buffer_.resize(64 * 1024);
+    }
+
+    ~ProcessScanner() {
+        if (proc_fd_ >= 0) {
+            ::close(proc_fd_);
+        }
+    }
+
+    ProcessScanner(const ProcessScanner &) = delete;
+    ProcessScanner &operator=(const ProcessScanner &) = delete;
+
+    bool valid() const {
+        return proc_fd_ >= 0;
+    }
+
+    // 全プロセスを1周スキャンし、processes と状態別集計を埋める。
+    // total_ticks_delta はシステム全体のCPUチック差分、core_count は
+    // %CPU を1コア=100%へ正規化するための論理コア数。走査中だけ生きる
+    // PIDリストやバッチ読みのスロットは周期アリーナから取る。uring が
+    // 使える場合は stat の読み取りをバッチ発行し、読み取りシステム
+    // コール数をプロセス数ぶんから数十分の一へ圧縮する。
+    bool scan(std::vector<ProcessInfo> &processes,
+              ProcessStateCounts &counts,
+              std::uint64_t total_ticks_delta,
+              std::size_t core_count,
+              TickArena &arena,
+#if BENCHMARK_TOOL_HAS_IO_URING
+              UringReader *uring = nullptr
+#else
+              void *uring = nullptr
+#endif
+    ) {
+        if (proc_fd_ < 0) {
+            return false;
+        }
+        processes.clear();
+        counts = ProcessStateCounts{};
+        prev_ticks_.begin_generation();
+
+        ArenaVector<std::int32_t> pids{ArenaAllocator<std::int32_t>(arena)};
+        pids.reserve(1024);
+        if (!collect_pids(pids)) {
+            return false;
+        }
+
+        // stat 読みが周期を支配する規模ではワーカープールへ分配する。
+        // プールは初めて閾値を超えたときに起動し、以後常駐する。
+        if (pids.size() >= parallel_threshold && !pool_.running()) {
+            pool_.start(proc_fd_, page_size_);
+        }
+        if (pool_.running() && pids.size() >= parallel_threshold) {
+            pool_.scan(pids.data(), pids.size(), processes);
+        } else
+#if BENCHMARK_TOOL_HAS_IO_URING
+        if (uring != nullptr && uring->available()) {
+            scan_pids_batched(*uring, pids, arena, processes);
+        } else
+#else
+        if (false) {
+            (void)uring;
+        } else
+#endif
+        {
+            for (const std::int32_t pid : pids) {
+                ProcessInfo info{};
+                if (read_process_stat(pid, info)) {
+                    processes.push_back(info);
+                }
+            }
+        }
+
+        for (ProcessInfo &info : processes) {
+            count_state(counts, info.state);
+            std::uint64_t previous = 0;
+            if (prev_ticks_.exchange(info.pid, info.cpu_ticks, previous) &&
+                total_ticks_delta > 0) {
+                const std::uint64_t delta = info.cpu_ticks - previous;
+                info.cpu_percent = static_cast<double>(delta) *
+                                   static_cast<double>(core_count ? core_count : 1) *
+                                   100.0 / static_cast<double>(total_ticks_delta);
+            }
+        }
+        counts.total = processes.size();
+        return true;
+    }
+
+    // stat 1行ぶんのテキストから必要フィールドを抜き出す。
+    // ベンチマーク互換のため残している薄い転送。実装は free 関数へ移した。
+    static bool parse_stat_text(const char *text, ssize_t length, std::int32_t pid,
+                                std::uint64_t page_size, ProcessInfo &info) {
+        return parse_proc_stat(text, length, pid, page_size, info);
+    }
+
+private:
+    // getdents64 が書き込むレコードの生レイアウト。glibc のヘッダに
+    // 依存しないよう自前で定義する。
+    struct LinuxDirent64 {
+        std::uint64_t d_ino;
+        std::int64_t d_off;
+        std::uint16_t d_reclen;
+        std::uint8_t d_type;
+        char d_name[];
+    };
+
+    // 数字のみのエントリ名をPIDとして解釈する。それ以外は0を返す。
+    static std::int32_t parse_pid(const char *name) {
+        std::int32_t pid = 0;
+        for (const char *p = name; *p != '\0'; ++p) {
+            if (*p < '0' || *p > '9') {
+                return 0;
+            }
+            pid = pid * 10 + (*p - '0');
+        }
+        return pid;
+    }
+
+    static void count_state(ProcessStateCounts &counts, char state) {
+        switch (state) {
+        case 'R':
+            ++counts.running;
+            break;
+        case 'T':
+        case 't':
+            ++counts.stopped;
+            break;
+        case 'Z':
+            ++counts.zombie;
+            break;
+        default:
+            // S/D/I などの待機系はまとめて sleeping として数える。
+            ++counts.sleeping;
+            break;
+        }
+    }
+
+    // /proc 直下を getdents64 で1周し、数字名エントリを pids へ集める。
+    bool collect_pids(ArenaVector<std::int32_t> &pids) {
+        if (::lseek(proc_fd_, 0, SEEK_SET) < 0) {
+            return false;
+        }
+        while (true) {
+            const long n = ::syscall(SYS_getdents64, proc_fd_,
+                                     dents_buffer_.data(), dents_buffer_.size());
+            if (n < 0) {
+                return false;
+            }
+            if (n == 0) {
+                return true;
+            }
+            for (long offset = 0; offset < n;) {
+                const auto *entry = reinterpret_cast<const LinuxDirent64 *>(
+                    dents_buffer_.data() + offset);
+                offset += entry->d_reclen;
+                const std::int32_t pid = parse_pid(entry->d_name);
+                if (pid > 0) {
+                    pids.push_back(pid);
+                }
+            }
+        }
+    }
+
+    // /proc/[pid]/stat を openat + 1回の read で取り込み必要フィールドを抜く。
+    bool read_process_stat(std::int32_t pid, ProcessInfo &info) {
+        char path[32];
+        build_proc_stat_path(pid, path);
+        const int fd = ::openat(proc_fd_, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        const ssize_t length = ::read(fd, stat_buffer_, sizeof(stat_buffer_) - 1);
+        ::close(fd);
+        if (length <= 0) {
+            return false;
+        }
+        return parse_proc_stat(stat_buffer_, length, pid, page_size_, info);
+    }
+
+#if BENCHMARK_TOOL_HAS_IO_URING
+    // stat の読み取りを io_uring でバッチ発行する。open/close は従来どおり
+    // 同期だが、読み取りは1バッチにつき submit/wait の1往復で済む。
+    // 読み取りスロットは周期アリーナから切り出す。
+    void scan_pids_batched(UringReader &uring,
+                           const ArenaVector<std::int32_t> &pid_list,
+                           TickArena &arena,
+                           std::vector<ProcessInfo> &processes) {
+        const std::size_t batch =
+            std::min<std::size_t>(uring.capacity(), batch_limit);
+        char *slots =
+            static_cast<char *>(arena.allocate(batch * stat_slot_size, 64));
+        int fds[batch_limit];
+        std::int32_t pids[batch_limit];
+        std::int32_t results[batch_limit];
+
+        std::size_t cursor = 0;
+        while (cursor < pid_list.size()) {
+            std::size_t queued = 0;
+            while (cursor < pid_list.size() && queued < batch) {
+                const std::int32_t pid = pid_list[cursor++];
+                char path[32];
+                build_proc_stat_path(pid, path);
+                const int fd = ::openat(proc_fd_, path, O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    continue;
+                }
+                fds[queued] = fd;
+                pids[queued] = pid;
+                results[queued] = -1;
+                uring.queue_read(fd, slots + queued * stat_slot_size,
+                                 stat_slot_size - 1, queued);
+                ++queued;
+            }
+            if (queued == 0) {
+                continue;
+            }
+            uring.submit_and_wait(results, queued);
+            for (std::size_t i = 0; i < queued; ++i) {
+                ::close(fds[i]);
+                if (results[i] <= 0) {
+                    continue;
+                }
+                char *buffer = slots + i * stat_slot_size;
+                buffer[results[i]] = '\0';
+                ProcessInfo info{};
+                if (parse_proc_stat(buffer, results[i], pids[i], page_size_, info)) {
+                    processes.push_back(info);
+                }
+            }
+        }
+    }
+#endif
+
+    static constexpr std::size_t batch_limit = 64;
+    static constexpr std::size_t stat_slot_size = 1024;
+    // 並列化する最小プロセス数。これ未満ではワーカーの起床コストが勝る。
+    static constexpr std::size_t parallel_threshold = 512;
+
+    int proc_fd_{-1};
+    ScanWorkerPool pool_;
+    std::vector<char> dents_buffer_;
+    PidTickMap prev_ticks_;
+    char stat_buffer_[4096];
+    const std::uint64_t page_size_{static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE))};
+};
+
+#endif // !_WIN32
@@ -0,0 +1,210 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// リングファイルへ書き込む1サンプル分の固定長レコード。
+// 可変長のコア別情報は持たず、集計値のみをパックして格納する。
+// レイアウトはファイル形式なのでフィールドの追加・並べ替えは
+// RING_FILE_VERSION の更新とセットで行うこと。
+struct HistoryRecord {
+    std::uint64_t timestamp_ms{};
+    std::uint64_t uptime_seconds{};
+    double cpu_usage{};
+    std::uint64_t mem_total_bytes{};
+    std::uint64_t mem_available_bytes{};
+    std::uint32_t tasks_total{};
+    std::uint32_t tasks_running{};
+    std::uint32_t tasks_sleeping{};
+    std::uint32_t tasks_stopped{};
+    std::uint32_t tasks_zombie{};
+    float load_one{};
+    float load_five{};
+    float load_fifteen{};
+    // ビット0:メモリ有効 1:タスク有効 2:ロード有効 3:状態別内訳あり
+    std::uint32_t flags{};
+};
+
+inline constexpr std::uint32_t RING_FILE_VERSION = 1;
+inline constexpr std::uint32_t record_flag_memory = 1u << 0;
+inline constexpr std::uint32_t record_flag_tasks = 1u << 1;
+inline constexpr std::uint32_t record_flag_loads = 1u << 2;
+inline constexpr std::uint32_t record_flag_task_states = 1u << 3;
+
+// リングファイル先頭のヘッダ。next_index は単調増加の書き込みカーソルで、
+// 実スロットは next_index % capacity に対応する。
+struct RingFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t capacity;
+    std::uint64_t next_index;
+};
+
+inline constexpr char ring_file_magic[8] = {'B', 'T', 'R', 'I', 'N', 'G', '0', '\0'};
+
+// 固定長レコードを事前確保済みの mmap リングファイルへ追記する記録器。
+// 追記は mmap 領域への memcpy だけで完結し、定常状態ではサンプルあたりの
+// システムコールがゼロになる。
+class RingRecorder {
+public:
+    RingRecorder() = default;
+
+    ~RingRecorder() {
+        close();
+    }
+
+    RingRecorder(const RingRecorder &) = delete;
+    RingRecorder &operator=(const RingRecorder &) = delete;
+
+    // 記録ファイルを作成(既存なら引き継ぎ)して書き込み用に mmap する。
+    // capacity はスロット数。1Hz で1日分なら 86400。
+    bool open_for_write(const char *path, std::uint64_t capacity) {
+        const int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        const std::size_t file_size =
+            sizeof(RingFileHeader) + capacity * sizeof(HistoryRecord);
+
+        struct stat st {};
+        const bool fresh = ::fstat(fd, &st) == 0 && st.st_size == 0;
+        if (::ftruncate(fd, static_cast<off_t>(file_size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void *mapping =
+            ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        mapping_ = mapping;
+        mapping_size_ = file_size;
+        header_ = static_cast<RingFileHeader *>(mapping);
+        records_ = reinterpret_cast<HistoryRecord *>(
+            static_cast<char *>(mapping) + sizeof(RingFileHeader));
+
+        if (fresh || std::memcmp(header_->magic, ring_file_magic, 8) != 0 ||
+            header_->version != RING_FILE_VERSION ||
+            header_->record_size != sizeof(HistoryRecord) ||
+            header_->capacity != capacity) {
+            // 新規または互換性の無い既存ファイルは初期化し直す。
+            std::memcpy(header_->magic, ring_file_magic, 8);
+            header_->version = RING_FILE_VERSION;
+            header_->record_size = sizeof(HistoryRecord);
+            header_->capacity = capacity;
+            header_->next_index = 0;
+        }
+        return true;
+    }
+
+    bool valid() const {
+        return header_ != nullptr;
+    }
+
+    // 1レコードをリングへ追記する。スロット書き込み後にカーソルを進める
+    // ことで、読み手が未完成のレコードを最新として拾わないようにする。
+    void append(const HistoryRecord &record) {
+        if (header_ == nullptr) {
+            return;
+        }
+        records_[header_->next_index % header_->capacity] = record;
+        header_->next_index += 1;
+    }
+
+    void close() {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+            mapping_ = nullptr;
+            header_ = nullptr;
+            records_ = nullptr;
+        }
+    }
+
+private:
+    void *mapping_{nullptr};
+    std::size_t mapping_size_{0};
+    RingFileHeader *header_{nullptr};
+    HistoryRecord *records_{nullptr};
+};
+
+// 記録済みリングファイルを読み取り専用で mmap し、古い順に辿る読み手。
+class RingReplay {
+public:
+    RingReplay() = default;
+
+    ~RingReplay() {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+
+    RingReplay(const RingReplay &) = delete;
+    RingReplay &operator=(const RingReplay &) = delete;
+
+    bool open(const char *path) {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 ||
+            static_cast<std::size_t>(st.st_size) < sizeof(RingFileHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void *mapping = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                               PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        mapping_ = mapping;
+        mapping_size_ = static_cast<std::size_t>(st.st_size);
+        header_ = static_cast<const RingFileHeader *>(mapping);
+        records_ = reinterpret_cast<const HistoryRecord *>(
+            static_cast<const char *>(mapping) + sizeof(RingFileHeader));
+
+        if (std::memcmp(header_->magic, ring_file_magic, 8) != 0 ||
+            header_->version != RING_FILE_VERSION ||
+            header_->record_size != sizeof(HistoryRecord)) {
+            return false;
+        }
+        return true;
+    }
+
+    // 保持しているレコード数。リングが一周した後は capacity に固定される。
+    std::uint64_t size() const {
+        if (header_ == nullptr) {
+            return 0;
+        }
+        return header_->next_index < header_->capacity ? header_->next_index
+                                                       : header_->capacity;
+    }
+
+    // 古い方から i 番目のレコードを返す。範囲チェックは呼び出し側で行う。
+    const HistoryRecord &at(std::uint64_t i) const {
+        const std::uint64_t oldest =
+            header_->next_index < header_->capacity
+                ? 0
+                : header_->next_index - header_->capacity;
+        return records_[(oldest + i) % header_->capacity];
+    }
+
+private:
+    void *mapping_{nullptr};
+    std::size_t mapping_size_{0};
+    const RingFileHeader *header_{nullptr};
+    const HistoryRecord *records_{nullptr};
+};
+
+#endif // !_WIN32
@@ -0,0 +1,345 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+#include "arena.h"
+#include "bulk_parser.h"
+#include "metrics.h"
+#include "proc_events.h"
+#include "proc_file.h"
+#include "process_table.h"
+#include "uring_reader.h"
+
+// "12.34" 形式の固定小数をその場で double へ読み取る。PSI の avg 値用。
+inline const char *parse_decimal(const char *p, const char *end, double &out) {
+    std::uint64_t integer_part = 0;
+    p = parse_uint64_bulk(p, end, integer_part);
+    double value = static_cast<double>(integer_part);
+    if (p != end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p != end && *p >= '0' && *p <= '9') {
+            value += static_cast<double>(*p - '0') * scale;
+            scale *= 0.1;
+            ++p;
+        }
+    }
+    out = value;
+    return p;
+}
+
+// Linux 実装のサンプラ。保持済み /proc の fd 群、再利用バッファ、
+// io_uring の状態をメンバとして抱え、コンパイル時に選択される
+// PlatformSampler の実体となる。仮想呼び出しは介在しない。
+class LinuxSampler {
+public:
+    LinuxSampler() {
+#if BENCHMARK_TOOL_HAS_IO_URING
+        uring_ready_ = uring_.init(128);
+#endif
+    }
+
+    LinuxSampler(const LinuxSampler &) = delete;
+    LinuxSampler &operator=(const LinuxSampler &) = delete;
+
+    // 周期の先頭で呼び、stat/meminfo/uptime の読み取りを io_uring の
+    // 1回の submit/wait へまとめて先読みする。非対応環境では何もせず、
+    // 各サンプラの pread 経路がそのまま使われる。
+    void begin_tick() {
+#if BENCHMARK_TOOL_HAS_IO_URING
+        if (!uring_ready_) {
+            return;
+        }
+        ProcFile *files[] = {&stat_, &meminfo_, &uptime_};
+        std::int32_t results[3] = {-1, -1, -1};
+        unsigned queued = 0;
+        for (std::uint64_t i = 0; i < 3; ++i) {
+            if (files[i]->valid() &&
+                uring_.queue_read(files[i]->fd(), files[i]->writable_data(),
+                                  static_cast<unsigned>(files[i]->capacity()), i)) {
+                ++queued;
+            }
+        }
+        if (queued == 0) {
+            return;
+        }
+        uring_.submit_and_wait(results, 3);
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (results[i] > 0 &&
+                static_cast<std::size_t>(results[i]) < files[i]->capacity()) {
+                files[i]->set_preloaded(results[i]);
+            }
+        }
+#endif
+    }
+
+    // /proc/stat を一括読みし、集計行と cpuN 行を同時に解析する。
+    // 取得に失敗した場合は false を返し外側で終了を促す。
+    bool sample_cpu(CpuSnapshot &snapshot) {
+        const ssize_t length = stat_.read_all();
+        if (length <= 0) {
+            return false;
+        }
+        return parse_stat_buffer(stat_.data(), length, snapshot);
+    }
+
+    // /proc/stat 形式のバッファを解析する本体。fd を持たないため
+    // フィクスチャからのベンチマークにもそのまま使える。
+    static bool parse_stat_buffer(const char *data, ssize_t length,
+                                  CpuSnapshot &snapshot) {
+        snapshot.cores.clear();
+        bool have_aggregate = false;
+        const char *p = data;
+        const char *end = p + length;
+        while (p < end) {
+            const char *line_end = find_line_end(p, end);
+            if (line_end - p > 3 && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+                if (p[3] == ' ') {
+                    CoreTicks aggregate{};
+                    accumulate_cpu_line(p + 4, line_end, aggregate);
+                    snapshot.idle_ticks = aggregate.idle_ticks;
+                    snapshot.total_ticks = aggregate.total_ticks;
+                    have_aggregate = true;
+                } else if (p[3] >= '0' && p[3] <= '9') {
+                    const char *fields = p + 3;
+                    while (fields != line_end && *fields != ' ') {
+                        ++fields;
+                    }
+                    CoreTicks core{};
+                    accumulate_cpu_line(fields, line_end, core);
+                    snapshot.cores.push_back(core);
+                }
+            } else if (have_aggregate && !snapshot.cores.empty()) {
+                // cpuN 行はファイル先頭に連続して並ぶため、外れた時点で打ち切る。
+                break;
+            }
+            p = line_end + 1;
+        }
+        return have_aggregate;
+    }
+
+    // /proc/meminfo を1パスで走査し、必要なフィールドをまとめて抜き出す。
+    // 行の切り出しと数値変換は bulk_parser のベクトル化経路に任せる。
+    MemoryStatus sample_memory() {
+        const ssize_t length = meminfo_.read_all();
+        if (length <= 0) {
+            return MemoryStatus{};
+        }
+        return parse_meminfo_buffer(meminfo_.data(), length);
+    }
+
+    // /proc/meminfo 形式のバッファを解析する本体。parse_stat_buffer と
+    // 同じくベンチマークから直接呼べるよう切り出している。
+    static MemoryStatus parse_meminfo_buffer(const char *data, ssize_t length) {
+        MemoryStatus status{};
+        const char *p = data;
+        const char *end = p + length;
+        while (p < end) {
+            const char *line_end = find_line_end(p, end);
+            switch (*p) {
+            case 'M':
+                if (!match_meminfo_line(p, line_end, "MemTotal:", 9,
+                                        status.total_bytes)) {
+                    match_meminfo_line(p, line_end, "MemAvailable:", 13,
+                                       status.available_bytes);
+                }
+                break;
+            case 'B':
+                match_meminfo_line(p, line_end, "Buffers:", 8, status.buffers_bytes);
+                break;
+            case 'C':
+                match_meminfo_line(p, line_end, "Cached:", 7, status.cached_bytes);
+                break;
+            case 'D':
+                match_meminfo_line(p, line_end, "Dirty:", 6, status.dirty_bytes);
+                break;
+            case 'S':
+                if (!match_meminfo_line(p, line_end, "SwapTotal:", 10,
+                                        status.swap_total_bytes) &&
+                    !match_meminfo_line(p, line_end, "SwapFree:", 9,
+                                        status.swap_free_bytes)) {
+                    match_meminfo_line(p, line_end, "Slab:", 5, status.slab_bytes);
+                }
+                break;
+            default:
+                break;
+            }
+            p = line_end + 1;
+        }
+        status.valid = status.total_bytes != 0;
+        return status;
+    }
+
+    // プロセス走査。スキャナの getdents64 + バッチ読み経路をそのまま使い、
+    // 状態別集計を TaskSummary へ写す。走査中の一時確保は arena から取る。
+    bool sample_tasks(TaskSummary &summary, std::vector<ProcessInfo> &processes,
+                      std::uint64_t total_ticks_delta, std::size_t core_count,
+                      TickArena &arena) {
+        ProcessStateCounts counts{};
+        if (!scanner_.valid() ||
+            !scanner_.scan(processes, counts, total_ticks_delta, core_count, arena
+#if BENCHMARK_TOOL_HAS_IO_URING
+                           ,
+                           uring_ready_ ? &uring_ : nullptr
+#endif
+                           )) {
+            return false;
+        }
+        summary.total = counts.total;
+        summary.running = counts.running;
+        summary.sleeping = counts.sleeping;
+        summary.stopped = counts.stopped;
+        summary.zombie = counts.zombie;
+        summary.has_states = true;
+        summary.valid = true;
+        // 全走査の実数でイベント推定の基準を合わせ直す。取りこぼしが
+        // あってもここで自然に修正される。
+        if (proc_events_ready_) {
+            proc_events_.drain();
+            proc_events_.reconcile(summary.total);
+        }
+        return true;
+    }
+
+    // 全走査を間引いた周期に、fork/exit イベントで総数だけを補正する。
+    // 状態別内訳はイベントからは分からないため次の全走査まで据え置く。
+    // コネクタを購読できない環境では false を返し、前回値のままとなる。
+    bool refresh_task_counts(TaskSummary &summary) {
+        if (!proc_events_ready_ || !summary.valid) {
+            return false;
+        }
+        proc_events_.drain();
+        const std::size_t total = proc_events_.estimated_total();
+        if (total == summary.total) {
+            return false;
+        }
+        // 増減分は内訳が分からないので sleeping へ寄せる(減少時も
+        // 過半が待機系なため、次の全走査までの近似としては十分)。
+        if (summary.has_states) {
+            const std::int64_t delta = static_cast<std::int64_t>(total) -
+                                       static_cast<std::int64_t>(summary.total);
+            const std::int64_t sleeping =
+                static_cast<std::int64_t>(summary.sleeping) + delta;
+            summary.sleeping = sleeping > 0 ? static_cast<std::size_t>(sleeping) : 0;
+        }
+        summary.total = total;
+        return true;
+    }
+
+    LoadAverages sample_load_averages() {
+        LoadAverages averages{};
+        double loads[3] = {};
+        if (getloadavg(loads, 3) == 3) {
+            averages.one = loads[0];
+            averages.five = loads[1];
+            averages.fifteen = loads[2];
+            averages.valid = true;
+        }
+        return averages;
+    }
+
+    // cpu/memory/io の PSI をまとめて読む。他サンプラと同じ
+    // 保持fd+pread+その場解析の流儀で、周期あたりの追加コストを抑える。
+    PressureSet sample_pressure() {
+        PressureSet set{};
+        set.cpu = parse_pressure(pressure_cpu_);
+        set.memory = parse_pressure(pressure_memory_);
+        set.io = parse_pressure(pressure_io_);
+        return set;
+    }
+
+    std::uint64_t uptime_seconds() {
+        const ssize_t length = uptime_.read_all();
+        if (length <= 0) {
+            return 0;
+        }
+        // 秒表示には小数部は不要なので '.' より前の整数部だけを読む。
+        std::uint64_t seconds = 0;
+        parse_uint64_bulk(uptime_.data(), uptime_.data() + length, seconds);
+        return seconds;
+    }
+
+private:
+    // "cpu" または "cpuN" 行の先頭10フィールドを合計/アイドルへ集約する。
+    // 行末(改行)までを対象とし、フィールド不足の行でも安全に打ち切る。
+    static void accumulate_cpu_line(const char *p, const char *end,
+                                    CoreTicks &ticks) {
+        std::uint64_t total = 0;
+        std::uint64_t idle = 0;
+        for (int i = 0; i < 10 && p != end; ++i) {
+            std::uint64_t value = 0;
+            p = parse_uint64_bulk(p, end, value);
+            total += value;
+            if (i == 3 || i == 4) {
+                idle += value;
+            }
+        }
+        ticks.idle_ticks = idle;
+        ticks.total_ticks = total;
+    }
+
+    // PSI 1ファイル("some avg10=... / full avg10=...")をその場で解析する。
+    // 行頭の some/full を見て avg10 と avg60 だけを抜き出す。
+    static PressureStatus parse_pressure(ProcFile &file) {
+        PressureStatus status{};
+        const ssize_t length = file.read_all();
+        if (length <= 0) {
+            return status;
+        }
+        const char *p = file.data();
+        const char *end = p + length;
+        while (p < end) {
+            const char *line_end = find_line_end(p, end);
+            const bool is_some = line_end - p > 5 && std::memcmp(p, "some ", 5) == 0;
+            const bool is_full = line_end - p > 5 && std::memcmp(p, "full ", 5) == 0;
+            if (is_some || is_full) {
+                double avg10 = 0.0;
+                double avg60 = 0.0;
+                const char *field = p + 5;
+                if (std::memcmp(field, "avg10=", 6) == 0) {
+                    field = parse_decimal(field + 6, line_end, avg10);
+                }
+                if (field != line_end && *field == ' ' &&
+                    std::memcmp(field + 1, "avg60=", 6) == 0) {
+                    parse_decimal(field + 7, line_end, avg60);
+                }
+                if (is_some) {
+                    status.some_avg10 = avg10;
+                    status.some_avg60 = avg60;
+                    status.valid = true;
+                } else {
+                    status.full_avg10 = avg10;
+                    status.full_avg60 = avg60;
+                    status.has_full = true;
+                }
+            }
+            p = line_end + 1;
+        }
+        return status;
+    }
+
+    ProcFile stat_{"/proc/stat", 64 * 1024};
+    ProcFile meminfo_{"/proc/meminfo"};
+    ProcFile uptime_{"/proc/uptime", 256};
+    // PSI は未対応カーネルではファイル自体が無く、open に失敗したまま
+    // valid=false の扱いになる。
+    ProcFile pressure_cpu_{"/proc/pressure/cpu", 512};
+    ProcFile pressure_memory_{"/proc/pressure/memory", 512};
+    ProcFile pressure_io_{"/proc/pressure/io", 512};
+    ProcessScanner scanner_;
+    ProcEventListener proc_events_;
+    const bool proc_events_ready_{proc_events_.init()};
+#if BENCHMARK_TOOL_HAS_IO_URING
+    UringReader uring_;
+    bool uring_ready_{false};
+#endif
+};
+
+#endif // !_WIN32
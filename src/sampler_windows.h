@@ -0,0 +1,108 @@
+#pragma once
+
+#ifdef _WIN32
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <windows.h>
+#include <psapi.h>
+
+#include "arena.h"
+#include "metrics.h"
+
+// Windows 実装のサンプラ。すべて API 呼び出しで完結するため保持する
+// 状態は無いが、コンパイル時に選択される PlatformSampler として
+// Linux 版と同じメソッド群を提供する。
+class WindowsSampler {
+public:
+    WindowsSampler() = default;
+
+    WindowsSampler(const WindowsSampler &) = delete;
+    WindowsSampler &operator=(const WindowsSampler &) = delete;
+
+    // 先読みの仕組みは無いため何もしない。Linux 版と対になる空実装。
+    void begin_tick() {}
+
+    bool sample_cpu(CpuSnapshot &snapshot) {
+        FILETIME idle{}, kernel{}, user{};
+        if (!GetSystemTimes(&idle, &kernel, &user)) {
+            return false;
+        }
+        snapshot.idle_ticks = file_time_to_uint64(idle);
+        snapshot.total_ticks = file_time_to_uint64(kernel) + file_time_to_uint64(user);
+        // コア別の値は取得しないため空のままとする。
+        snapshot.cores.clear();
+        return true;
+    }
+
+    MemoryStatus sample_memory() {
+        MemoryStatus status{};
+        MEMORYSTATUSEX memory_info{};
+        memory_info.dwLength = sizeof(memory_info);
+        if (GlobalMemoryStatusEx(&memory_info)) {
+            status.total_bytes = memory_info.ullTotalPhys;
+            status.available_bytes = memory_info.ullAvailPhys;
+            status.valid = true;
+        }
+        return status;
+    }
+
+    // 稼働中プロセス数を数え上げ、Tasks 行に利用する。状態別内訳や
+    // プロセス表は提供しないため processes は空のままとなる。
+    // EnumProcesses の成長するIDバッファは周期アリーナから取る。
+    bool sample_tasks(TaskSummary &summary, std::vector<ProcessInfo> &processes,
+                      std::uint64_t /*total_ticks_delta*/,
+                      std::size_t /*core_count*/, TickArena &arena) {
+        processes.clear();
+        ArenaVector<DWORD> process_ids{ArenaAllocator<DWORD>(arena)};
+        process_ids.resize(1024);
+        DWORD bytes_returned = 0;
+        while (true) {
+            if (!EnumProcesses(process_ids.data(),
+                               static_cast<DWORD>(process_ids.size() * sizeof(DWORD)),
+                               &bytes_returned)) {
+                return false;
+            }
+            const std::size_t count = bytes_returned / sizeof(DWORD);
+            if (count < process_ids.size()) {
+                summary.total = count;
+                summary.valid = true;
+                return true;
+            }
+            process_ids.resize(process_ids.size() * 2);
+        }
+    }
+
+    // プロセスイベントの購読経路は無いため常に false。Linux 版と対になる。
+    bool refresh_task_counts(TaskSummary & /*summary*/) {
+        return false;
+    }
+
+    // ロードアベレージは取得不能なので valid=false として N/A 表示にする。
+    LoadAverages sample_load_averages() {
+        return LoadAverages{};
+    }
+
+    // PSI 相当の情報は無いため常に空集合を返す。
+    PressureSet sample_pressure() {
+        return PressureSet{};
+    }
+
+    std::uint64_t uptime_seconds() {
+        return static_cast<std::uint64_t>(GetTickCount64() / 1000ULL);
+    }
+
+private:
+    // FILETIME を 64bit 値へ詰め替えるヘルパー。
+    // CPU 時刻計算で扱いやすいよう整数化する。
+    static std::uint64_t file_time_to_uint64(const FILETIME &ft) {
+        ULARGE_INTEGER li;
+        li.LowPart = ft.dwLowDateTime;
+        li.HighPart = ft.dwHighDateTime;
+        return li.QuadPart;
+    }
+};
+
+#endif // _WIN32
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_buffer.h"
+
+// 直近サンプルの傾向を1行に収める Unicode スパークライン。値の保持は
+// 固定長の循環バッファ、グリフ選択は事前計算した百分率→段のテーブルで
+// 行い、描画はフレームバッファへの UTF-8 追記のみ。ヒープ確保も
+// 書式化関数の呼び出しも発生しない。
+
+// 8段のブロック要素 (U+2581..U+2588) を UTF-8 で並べたもの。
+inline constexpr const char *sparkline_glyphs[8] = {
+    "\xe2\x96\x81", "\xe2\x96\x82", "\xe2\x96\x83", "\xe2\x96\x84",
+    "\xe2\x96\x85", "\xe2\x96\x86", "\xe2\x96\x87", "\xe2\x96\x88",
+};
+
+// 百分率(0..100)から段(0..7)への変換表。毎グリフの除算を省く。
+struct SparklineLevelTable {
+    std::uint8_t levels[101];
+
+    constexpr SparklineLevelTable() : levels() {
+        for (int percent = 0; percent <= 100; ++percent) {
+            int level = percent * 8 / 101;
+            levels[percent] = static_cast<std::uint8_t>(level);
+        }
+    }
+};
+
+inline constexpr SparklineLevelTable sparkline_level_table{};
+
+// 1系列分の履歴。百分率へ正規化済みの値を押し込み、古い順に描画する。
+class Sparkline {
+public:
+    static constexpr std::size_t capacity = 30;
+
+    // 値を百分率として記録する。範囲外はテーブル参照前に丸める。
+    void push(double percent) {
+        int clamped = static_cast<int>(percent);
+        if (clamped < 0) {
+            clamped = 0;
+        } else if (clamped > 100) {
+            clamped = 100;
+        }
+        head_ = (head_ + 1) % capacity;
+        levels_[head_] = sparkline_level_table.levels[clamped];
+        if (filled_ < capacity) {
+            ++filled_;
+        }
+    }
+
+    // 古い順にグリフを追記する。履歴が浅い間は左端を空白で詰めて
+    // 右端が常に最新になるよう揃える。
+    void append_to(FrameBuffer &frame) const {
+        for (std::size_t i = filled_; i < capacity; ++i) {
+            frame.append(' ');
+        }
+        for (std::size_t back = filled_; back > 0; --back) {
+            const std::size_t index = (head_ + capacity - back + 1) % capacity;
+            frame.append(sparkline_glyphs[levels_[index]]);
+        }
+    }
+
+private:
+    std::uint8_t levels_[capacity]{};
+    std::size_t head_{0};
+    std::size_t filled_{0};
+};
+
+// 画面に出す3系列をまとめたもの。描画側が所有しサンプルごとに押し込む。
+struct SparklineSet {
+    Sparkline cpu;
+    Sparkline memory;
+    Sparkline load;
+};
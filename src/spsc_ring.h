@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// 単一生産者/単一消費者前提のロックフリーリングバッファ。
+// 収集スレッドと描画スレッドの橋渡し専用で、ロック待ちによる
+// サンプリング周期の乱れを避けるために用いる。容量は2の冪に固定する。
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    // 要素を末尾へ追加する。満杯の場合は false を返し値を破棄する。
+    // 生産者スレッド以外から呼んではならない。
+    bool push(T value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots_[tail & (Capacity - 1)] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 先頭要素を取り出す。空の場合は false を返す。
+    // 消費者スレッド以外から呼んではならない。
+    bool pop(T &out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = std::move(slots_[head & (Capacity - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> slots_{};
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// ホットパス各段の所要時間を記録する、2の冪バケットの固定長ヒストグラム。
+// 記録はビット走査とリラックスド原子加算だけで、確保もロックも行わない。
+// 収集スレッドが書き、描画スレッドが読むため、値は表示用の近似と割り切る。
+class LatencyHistogram {
+public:
+    static constexpr std::size_t bucket_count = 64;
+
+    void record(std::uint64_t nanoseconds) {
+        const std::size_t bucket =
+            nanoseconds == 0 ? 0
+                             : static_cast<std::size_t>(64 - __builtin_clzll(nanoseconds));
+        buckets_[bucket < bucket_count ? bucket : bucket_count - 1].fetch_add(
+            1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t seen = max_ns_.load(std::memory_order_relaxed);
+        while (nanoseconds > seen &&
+               !max_ns_.compare_exchange_weak(seen, nanoseconds,
+                                              std::memory_order_relaxed)) {
+        }
+    }
+
+    // 指定分位が属するバケットの下限(ナノ秒)を返す。分解能は2倍刻み。
+    std::uint64_t percentile_ns(double fraction) const {
+        const std::uint64_t total = count_.load(std::memory_order_relaxed);
+        if (total == 0) {
+            return 0;
+        }
+        const std::uint64_t target =
+            static_cast<std::uint64_t>(static_cast<double>(total) * fraction);
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            cumulative += buckets_[i].load(std::memory_order_relaxed);
+            if (cumulative > target) {
+                return i < 2 ? i : (1ULL << (i - 1));
+            }
+        }
+        return max_ns_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t max_ns() const {
+        return max_ns_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> max_ns_{0};
+};
+
+// 計測対象の段。メインループの呼び出し単位に対応する。
+enum class Stage : std::size_t {
+    cpu = 0,
+    memory,
+    tasks,
+    loads,
+    io,
+    render,
+    count,
+};
+
+inline const char *stage_name(Stage stage) {
+    switch (stage) {
+    case Stage::cpu:
+        return "cpu";
+    case Stage::memory:
+        return "mem";
+    case Stage::tasks:
+        return "tasks";
+    case Stage::loads:
+        return "load";
+    case Stage::io:
+        return "io";
+    case Stage::render:
+        return "render";
+    default:
+        return "?";
+    }
+}
+
+// 全段のヒストグラムをまとめた自己プロファイル面。
+struct StageStats {
+    std::array<LatencyHistogram, static_cast<std::size_t>(Stage::count)> histograms;
+
+    LatencyHistogram &of(Stage stage) {
+        return histograms[static_cast<std::size_t>(stage)];
+    }
+
+    const LatencyHistogram &of(Stage stage) const {
+        return histograms[static_cast<std::size_t>(stage)];
+    }
+};
+
+// スコープの生存期間を計測して指定段へ記録するガード。
+class StageTimer {
+public:
+    StageTimer(StageStats &stats, Stage stage)
+        : stats_(stats), stage_(stage),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_.of(stage_).record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    StageStats &stats_;
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
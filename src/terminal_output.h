@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// 画面モード用の非ブロッキング標準出力。端末が停滞(サスペンドされた
+// SSH、遅いページャ)しても write(2) で描画スレッドが眠り込まないよう、
+// stdout を O_NONBLOCK にして書けなかった残りを内部キューへ積む。
+// 呼び出し側はキューが空のときだけ新フレームを送るため、キューには
+// 高々1フレームしか残らず(有界)、停滞中の中間フレームは端末へ
+// 届くことなく合体される。収集スレッドは stdout に一切触れないので、
+// サンプリング周期は端末スループットと構造的に独立している。
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+class NonblockingStdout {
+public:
+    NonblockingStdout() = default;
+
+    ~NonblockingStdout() {
+        // 端末の fd はシェルと共有しているため、必ず元へ戻す。
+        if (enabled_) {
+            ::fcntl(STDOUT_FILENO, F_SETFL, saved_flags_);
+        }
+    }
+
+    NonblockingStdout(const NonblockingStdout &) = delete;
+    NonblockingStdout &operator=(const NonblockingStdout &) = delete;
+
+    void enable() {
+        saved_flags_ = ::fcntl(STDOUT_FILENO, F_GETFL);
+        if (saved_flags_ < 0) {
+            return;
+        }
+        enabled_ =
+            ::fcntl(STDOUT_FILENO, F_SETFL, saved_flags_ | O_NONBLOCK) == 0;
+        pending_.reserve(64 * 1024);
+    }
+
+    // 積み残しを書けるだけ書く。キューが空になれば true、端末がまだ
+    // 詰まっていれば false。
+    bool drain() {
+        while (offset_ < pending_.size()) {
+            const ssize_t n = ::write(STDOUT_FILENO, pending_.data() + offset_,
+                                      pending_.size() - offset_);
+            if (n > 0) {
+                offset_ += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return false;
+            }
+            // 回復不能(EPIPE 等)。捨てて先へ進む。
+            break;
+        }
+        pending_.clear();
+        offset_ = 0;
+        return true;
+    }
+
+    // 1フレームを送出する。まず直接書き、書き切れなかった残りだけを
+    // キューへ退避する。drain()==true を確認してから呼ぶ約束なので、
+    // ここで積まれるのは常に1フレーム分以下となる。
+    void submit(const char *data, std::size_t size) {
+        std::size_t written = 0;
+        while (written < size) {
+            const ssize_t n =
+                ::write(STDOUT_FILENO, data + written, size - written);
+            if (n > 0) {
+                written += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pending_.assign(data + written, data + size);
+                offset_ = 0;
+            }
+            return;
+        }
+    }
+
+private:
+    std::vector<char> pending_;
+    std::size_t offset_{0};
+    int saved_flags_{0};
+    bool enabled_{false};
+};
+
+#else
+
+#include <cstdio>
+
+// Windows のコンソールには O_NONBLOCK 相当が無いため、従来どおりの
+// ブロッキング書き込みに退化する空実装。
+class NonblockingStdout {
+public:
+    NonblockingStdout() = default;
+
+    NonblockingStdout(const NonblockingStdout &) = delete;
+    NonblockingStdout &operator=(const NonblockingStdout &) = delete;
+
+    void enable() {}
+
+    bool drain() {
+        return true;
+    }
+
+    void submit(const char *data, std::size_t size) {
+        std::fwrite(data, 1, size, stdout);
+        std::fflush(stdout);
+    }
+};
+
+#endif // !_WIN32
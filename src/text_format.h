@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#include "frame_buffer.h"
+
+// フレームバッファ向けの表示整形ヘルパー。描画本体とベンチマークの
+// 両方から使うため、main から切り出している。
+
+// 秒数を「日, 時:分」形式でフレームバッファへ追記する。
+// 1分未満の短時間は "XXs" として短く表示する。
+inline void append_uptime(FrameBuffer &frame, std::uint64_t seconds) {
+    if (seconds < 60) {
+        frame.append_uint(seconds);
+        frame.append('s');
+        return;
+    }
+
+    const std::uint64_t days = seconds / 86400ULL;
+    seconds %= 86400ULL;
+    const std::uint64_t hours = seconds / 3600ULL;
+    seconds %= 3600ULL;
+    const std::uint64_t minutes = seconds / 60ULL;
+
+    if (days > 0) {
+        frame.append_uint(days);
+        frame.append(days > 1 ? " days, " : " day, ");
+    }
+    frame.append_uint_2digit(hours);
+    frame.append(':');
+    frame.append_uint_2digit(minutes);
+}
+
+// 現在時刻を HH:MM:SS フォーマットでフレームバッファへ追記する。
+// Windows/Linux それぞれのスレッドセーフな localtime を利用する。
+inline void append_current_time(FrameBuffer &frame) {
+    const auto now = std::chrono::system_clock::now();
+    const std::time_t now_c = std::chrono::system_clock::to_time_t(now);
+#ifdef _WIN32
+    std::tm local_tm;
+    localtime_s(&local_tm, &now_c);
+#else
+    std::tm local_tm;
+    localtime_r(&now_c, &local_tm);
+#endif
+    frame.append_uint_2digit(static_cast<std::uint64_t>(local_tm.tm_hour));
+    frame.append(':');
+    frame.append_uint_2digit(static_cast<std::uint64_t>(local_tm.tm_min));
+    frame.append(':');
+    frame.append_uint_2digit(static_cast<std::uint64_t>(local_tm.tm_sec));
+}
+
+// バイト数を MiB 単位の小数1桁表記でフレームバッファへ追記する。
+inline void append_memory_mib(FrameBuffer &frame, std::uint64_t bytes) {
+    frame.append_fixed(static_cast<double>(bytes) / (1024.0 * 1024.0), 1);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "metrics.h"
+
+// プロセス表の整列キー。キー操作でトグルされる。
+enum class ProcessSortKey {
+    cpu,
+    memory,
+};
+
+// 整列キー上位 N 件だけを processes の先頭へ降順で寄せる選別器。
+// 前周期に表示した最下位のキー値(カットオフ)を保持し、順位が
+// 安定している限り候補集めは全件1パスの比較だけで済む(表示中の
+// プロセスは必ずカットオフ以上なので、候補がN件あれば真の上位Nは
+// すべて候補に含まれる)。届かない周期だけ全体選別へ退避する。
+class TopProcessSelector {
+public:
+    // 整列キーを切り替える。カットオフは前キーの値なので捨てる。
+    void set_sort_key(ProcessSortKey key) {
+        if (key != sort_key_) {
+            sort_key_ = key;
+            cutoff_ = -1.0;
+        }
+    }
+
+    ProcessSortKey sort_key() const {
+        return sort_key_;
+    }
+
+    // processes の先頭 rows 件をキー降順の上位にする。末尾側の順序は
+    // 保証しない。rows はたかだか数十を想定しており、並べ替え自体は
+    // 候補集合に対してのみ行う。
+    void select(std::vector<ProcessInfo> &processes, std::size_t rows) {
+        const auto key_of = [this](const ProcessInfo &info) {
+            return sort_key_ == ProcessSortKey::cpu
+                       ? info.cpu_percent
+                       : static_cast<double>(info.rss_bytes);
+        };
+        const auto by_key_desc = [&](std::size_t a, std::size_t b) {
+            return key_of(processes[a]) > key_of(processes[b]);
+        };
+
+        if (processes.size() <= rows) {
+            std::sort(processes.begin(), processes.end(),
+                      [&](const ProcessInfo &a, const ProcessInfo &b) {
+                          return key_of(a) > key_of(b);
+                      });
+            cutoff_ = processes.empty() ? -1.0 : key_of(processes.back());
+            return;
+        }
+
+        candidates_.clear();
+        if (cutoff_ >= 0.0) {
+            for (std::size_t i = 0; i < processes.size(); ++i) {
+                if (key_of(processes[i]) >= cutoff_) {
+                    candidates_.push_back(i);
+                }
+            }
+        }
+        // 全体が沈んで前周期の下限以上が表示行数に届かないときだけ、
+        // 全件を候補にして nth_element で選び直す。
+        if (candidates_.size() < rows) {
+            candidates_.resize(processes.size());
+            std::iota(candidates_.begin(), candidates_.end(), std::size_t{0});
+        }
+        if (candidates_.size() > rows) {
+            std::nth_element(candidates_.begin(), candidates_.begin() + rows,
+                             candidates_.end(), by_key_desc);
+            candidates_.resize(rows);
+        }
+        std::sort(candidates_.begin(), candidates_.end(), by_key_desc);
+
+        // 選別結果を退避してから先頭へ書き戻す。候補の添字が先頭 rows を
+        // 指していても上書きで壊れないようにするためのコピー。
+        selected_.clear();
+        for (const std::size_t index : candidates_) {
+            selected_.push_back(processes[index]);
+        }
+        std::copy(selected_.begin(), selected_.end(), processes.begin());
+        cutoff_ = key_of(selected_.back());
+    }
+
+private:
+    std::vector<std::size_t> candidates_;
+    std::vector<ProcessInfo> selected_;
+    // 前周期に表示した最下位のキー値。負なら未初期化で全件選別する。
+    double cutoff_{-1.0};
+    ProcessSortKey sort_key_{ProcessSortKey::cpu};
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#if !defined(_WIN32) && __has_include(<linux/io_uring.h>)
+#define BENCHMARK_TOOL_HAS_IO_URING 1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 1周期分の /proc 読み取りを io_uring の1回の submit/wait にまとめる
+// バッチリーダ。liburing には依存せず、生のシステムコールとリング
+// mmap を直接扱う。カーネルが io_uring 非対応の場合は init が失敗し、
+// 呼び出し側は従来の pread 経路へフォールバックする。
+class UringReader {
+public:
+    UringReader() = default;
+
+    ~UringReader() {
+        if (sq_ring_ != nullptr && sq_ring_ != MAP_FAILED) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sqes_ != nullptr && sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+
+    UringReader(const UringReader &) = delete;
+    UringReader &operator=(const UringReader &) = delete;
+
+    // entries 件(2の冪)のリングを確保する。失敗時は false。
+    bool init(unsigned entries) {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(
+            ::syscall(SYS_io_uring_setup, entries, &params));
+        if (ring_fd_ < 0) {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(__u32);
+        cq_ring_size_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+            sq_ring_size_ = cq_ring_size_;
+        }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        if (single_mmap) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, ring_fd_,
+                              IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) {
+                return false;
+            }
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+
+        auto *sq = static_cast<char *>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+        auto *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        capacity_ = params.sq_entries;
+        ready_ = true;
+        return true;
+    }
+
+    bool available() const {
+        return ready_;
+    }
+
+    unsigned capacity() const {
+        return capacity_;
+    }
+
+    // オフセット0からの読み取り要求を1件積む。submit するまで発行されない。
+    // user_data は完了時に results の添字として使われる。
+    bool queue_read(int fd, void *buffer, unsigned length, std::uint64_t user_data) {
+        if (!ready_ || queued_ >= capacity_) {
+            return false;
+        }
+        const unsigned tail = local_tail_;
+        const unsigned index = tail & sq_mask_;
+        io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe->len = length;
+        sqe->off = 0;
+        sqe->user_data = user_data;
+        sq_array_[index] = index;
+        local_tail_ = tail + 1;
+        ++queued_;
+        return true;
+    }
+
+    // 積んだ要求を1回の io_uring_enter で発行し、全完了を待つ。
+    // 各完了の res(読めたバイト数または負のerrno)を user_data 添字で
+    // results へ書き込み、取り込んだ完了数を返す。
+    int submit_and_wait(std::int32_t *results, std::size_t result_capacity) {
+        if (!ready_ || queued_ == 0) {
+            return 0;
+        }
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+        const unsigned to_submit = queued_;
+        queued_ = 0;
+        const long entered = ::syscall(SYS_io_uring_enter, ring_fd_, to_submit,
+                                       to_submit, IORING_ENTER_GETEVENTS, nullptr,
+                                       0);
+        if (entered < 0) {
+            return -1;
+        }
+
+        int reaped = 0;
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data < result_capacity) {
+                results[cqe.user_data] = cqe.res;
+            }
+            ++head;
+            ++reaped;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return reaped;
+    }
+
+private:
+    int ring_fd_{-1};
+    bool ready_{false};
+    unsigned capacity_{0};
+    unsigned queued_{0};
+    unsigned local_tail_{0};
+
+    void *sq_ring_{nullptr};
+    std::size_t sq_ring_size_{0};
+    void *cq_ring_{nullptr};
+    std::size_t cq_ring_size_{0};
+    void *sqes_{nullptr};
+    std::size_t sqes_size_{0};
+
+    unsigned *sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned *sq_array_{nullptr};
+    unsigned *cq_head_{nullptr};
+    unsigned *cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe *cqes_{nullptr};
+};
+
+#else
+#define BENCHMARK_TOOL_HAS_IO_URING 0
+#endif